@@ -0,0 +1,635 @@
+/**
+ * @fileoverview Copyright (c) 2019-2021, Stefano Gualandi,
+ *               via Ferrata, 1, I-27100, Pavia, Italy
+ *
+ * @author stefano.gualandi@gmail.com (Stefano Gualandi)
+ *
+ */
+
+#pragma once
+
+#include "KWD_NetSimplex.h"
+
+#include <cmath>
+
+namespace KWD {
+
+// Auction algorithm with epsilon scaling for the bipartite transportation
+// problem between two histograms on the same n points, with the euclidean
+// distance as cost (Bertsekas and Castanon, 1989). The node i < n is the
+// source of the point i and the node n + i is its sink. The costs are
+// computed on the fly from the coordinates, so the memory is linear in n.
+//
+// Every sink holds the bids that bought its mass, at most one per source,
+// each one with the price paid for it. A source with mass left buys the
+// cheapest mass of its best sinks at a price that keeps them within epsilon
+// of any other option, as in the auction for real-valued transport of
+// Walsh and Dieci: the mass held by lower bids goes back to their sources.
+// The bids of a round are computed in parallel and then applied in order
+// (Jacobi auction). Every phase starts from the prices of the previous one
+// and divides epsilon by ALPHA, until the gap between the cost of the flow
+// and the dual bound given by the prices is within the tolerance.
+template <typename V = int64_t> class Auction {
+public:
+  // The type of the flow amounts and supply values
+  typedef V Value;
+
+  // Scaling factor of epsilon between two phases
+  static const int ALPHA = 4;
+  // Largest number of sinks in a bid
+  static const int K = 8;
+  // Sinks scanned at once by a bid
+  static const int BLOCK = 64;
+
+private:
+  typedef std::vector<int> IntVector;
+  typedef std::vector<Value> ValueVector;
+  typedef std::vector<double> DoubleVector;
+
+  // A bid held by a sink
+  struct Bid {
+    double price;
+    int source;
+    Value amount;
+    Bid(double p, int s, Value a) : price(p), source(s), amount(a) {}
+    // Order of a min-heap on the price
+    bool operator<(const Bid &o) const { return price > o.price; }
+  };
+
+  // The sinks of a bid, with the mass to buy from each one, and the cost
+  // plus price of the best option left to the source
+  struct Order {
+    int count;
+    int sink[K];
+    Value amount[K];
+    double lambda;
+  };
+
+  int _n;
+  DoubleVector _x;
+  DoubleVector _y;
+  ValueVector _supply;
+
+  // Sources and sinks with positive mass
+  IntVector _sources;
+  IntVector _sinks;
+  DoubleVector _sink_x;
+  DoubleVector _sink_y;
+  // The sinks are sorted along a Morton curve, and grouped in blocks of
+  // BLOCK sinks with their bounding box and their lowest entry price
+  std::vector<uint64_t> _sink_key;
+  DoubleVector _block_x0, _block_x1, _block_y0, _block_y1;
+  DoubleVector _block_entry;
+
+  // Mass left to every source, and mass bought by every sink
+  ValueVector _left;
+  ValueVector _held;
+  std::vector<std::vector<Bid>> _bids;
+  // Price to pay to enter every sink: its base price if it is not full,
+  // the lowest bid otherwise
+  DoubleVector _entry;
+
+  double _epsilon;
+  double _primal;
+  double _dual;
+  double _opt_tolerance;
+  int _threads;
+
+  double _runtime;
+  std::chrono::steady_clock::time_point _deadline;
+  const CancelToken *_cancel;
+  std::string _verbosity;
+
+  uint64_t _iterations;
+
+public:
+  Auction(int n, const int *Xs, const int *Ys)
+      : _n(n), _x(n), _y(n), _supply(2 * n, 0), _epsilon(0), _primal(0),
+        _dual(0), _opt_tolerance(1e-06), _threads(1), _runtime(0.0),
+        _deadline(deadlineAfter(std::numeric_limits<double>::max())),
+        _cancel(nullptr), _verbosity(KWD_VAL_INFO), _iterations(0) {
+    if (std::numeric_limits<Value>::is_exact == false)
+      throw std::runtime_error("The flow type of Auction must be an integer");
+
+    for (int i = 0; i < n; ++i) {
+      _x[i] = Xs[i];
+      _y[i] = Ys[i];
+    }
+  }
+
+  // Set the supply of node i: the sources have a positive supply, the sinks
+  // a negative one
+  void addNode(int i, Value b) { _supply[i] = b; }
+
+  void setTimelimit(double t) {
+    _deadline = deadlineAfter(t);
+    PRINT("INFO: change <timelimit> to %f\n", t);
+  }
+  void setCancelToken(const CancelToken *token) { _cancel = token; }
+  void setVerbosity(std::string v) {
+    _verbosity = v;
+    PRINT("INFO: change <verbosity> to %s\n", v.c_str());
+  }
+  // Largest gap between the cost of the flow and its dual bound, per unit
+  // of mass
+  void setOptTolerance(double o) {
+    _opt_tolerance = o;
+    PRINT("INFO: change <opt_tolerance> to %f\n", o);
+  }
+  void setThreads(int t) {
+    _threads = (std::max)(1, t);
+    PRINT("INFO: change <threads> to %d\n", _threads);
+  }
+
+  double runtime() const { return _runtime; }
+
+  // Number of bids
+  uint64_t iterations() const { return _iterations; }
+
+  size_t num_nodes() const { return _sources.size() + _sinks.size(); }
+  size_t num_arcs() const { return _sources.size() * _sinks.size(); }
+
+  // Cost of the flow, and lower bound on the optimal cost
+  double totalCost() const { return _primal; }
+  double lowerBound() const { return _dual; }
+
+  ProblemType run() {
+    auto start_t = std::chrono::steady_clock::now();
+    _iterations = 0;
+
+    _sources.clear();
+    _sinks.clear();
+    Value mass = 0;
+    Value sum_supply = 0;
+    for (int i = 0; i < 2 * _n; ++i) {
+      sum_supply += _supply[i];
+      if (i < _n && _supply[i] > 0) {
+        _sources.push_back(i);
+        mass += _supply[i];
+      }
+      if (i >= _n && _supply[i] < 0)
+        _sinks.push_back(i - _n);
+    }
+    if (sum_supply != 0 || (_sources.empty() != _sinks.empty()))
+      return ProblemType::INFEASIBLE;
+
+    std::sort(_sinks.begin(), _sinks.end(), [this](int a, int b) {
+      return mortonKey(a) < mortonKey(b);
+    });
+
+    // The arrays scanned by the bids are padded to whole blocks with sinks
+    // far away from the grid
+    int m = int(_sinks.size());
+    int m_pad = (m + BLOCK - 1) / BLOCK * BLOCK;
+    _sink_x.assign(m_pad, 1e9);
+    _sink_y.assign(m_pad, 1e9);
+    _entry.assign(m_pad, 0.0);
+    _held.assign(m, 0);
+    _bids.assign(m, std::vector<Bid>());
+    _sink_key.resize(m);
+    for (int k = 0; k < m; ++k) {
+      _sink_x[k] = _x[_sinks[k]];
+      _sink_y[k] = _y[_sinks[k]];
+      _sink_key[k] = mortonKey(_sinks[k]);
+    }
+
+    int nb = m_pad / BLOCK;
+    _block_x0.assign(nb, std::numeric_limits<double>::max());
+    _block_y0.assign(nb, std::numeric_limits<double>::max());
+    _block_x1.assign(nb, std::numeric_limits<double>::lowest());
+    _block_y1.assign(nb, std::numeric_limits<double>::lowest());
+    _block_entry.assign(nb, 0.0);
+    for (int k = 0; k < m; ++k) {
+      int b = k / BLOCK;
+      _block_x0[b] = (std::min)(_block_x0[b], _sink_x[k]);
+      _block_x1[b] = (std::max)(_block_x1[b], _sink_x[k]);
+      _block_y0[b] = (std::min)(_block_y0[b], _sink_y[k]);
+      _block_y1[b] = (std::max)(_block_y1[b], _sink_y[k]);
+    }
+    _left.assign(_n, 0);
+
+    // The first epsilon is a fraction of the largest cost
+    double c_max = 0.0;
+    for (int i : _sources)
+      for (int k = 0; k < m; ++k)
+        c_max = (std::max)(c_max, dist(i, k));
+    _epsilon = (std::max)(c_max, 1.0) / ALPHA;
+
+    ProblemType status = ProblemType::OPTIMAL;
+    _primal = 0.0;
+    _dual = 0.0;
+    for (bool first = true; !_sources.empty(); first = false) {
+      status = phase(first);
+      if (status != ProblemType::OPTIMAL)
+        break;
+
+      computeBounds();
+      if (_verbosity == KWD_VAL_DEBUG)
+        PRINT("Auction phase | epsilon: %.3e, bids: %ld, gap: %.3e\n",
+              _epsilon, (long)_iterations, (_primal - _dual) / double(mass));
+
+      if (_primal - _dual <= _opt_tolerance * double(mass) ||
+          _epsilon < 1e-14 * c_max)
+        break;
+      _epsilon = _epsilon / ALPHA;
+    }
+
+    auto end_t = std::chrono::steady_clock::now();
+    _runtime = double(std::chrono::duration_cast<std::chrono::milliseconds>(
+                          end_t - start_t)
+                          .count()) /
+               1000;
+    return status;
+  }
+
+private:
+  // Morton key of the point i, with the coordinates shifted to unsigned
+  uint64_t mortonKey(int i) const {
+    uint64_t x = uint64_t(int64_t(_x[i]) - INT32_MIN);
+    uint64_t y = uint64_t(int64_t(_y[i]) - INT32_MIN);
+    uint64_t key = 0;
+    for (int b = 0; b < 32; ++b)
+      key |= ((x >> b) & 1) << (2 * b) | ((y >> b) & 1) << (2 * b + 1);
+    return key;
+  }
+
+  double dist(int i, int k) const {
+    double dx = _x[i] - _sink_x[k];
+    double dy = _y[i] - _sink_y[k];
+    return std::sqrt(dx * dx + dy * dy);
+  }
+
+  // Check the deadline and the cancel token
+  bool interrupted(ProblemType &status) const {
+    if (_cancel != nullptr && _cancel->cancelled()) {
+      status = ProblemType::CANCELLED;
+      return true;
+    }
+    if (std::chrono::steady_clock::now() > _deadline) {
+      status = ProblemType::TIMELIMIT;
+      return true;
+    }
+    return false;
+  }
+
+  // Compute the bid of source i at the current prices: buy the cheapest
+  // offers of the best sinks, in order of cost plus price, until the mass
+  // left is covered or the next offer of a sink already taken is cheaper.
+  // Every unit is paid lambda - cost + epsilon, where lambda is the cost
+  // plus price of the cheapest option not taken, so that the units bought
+  // are epsilon-optimal for the source. The units that the source already
+  // holds below lambda are raised to the same price.
+  void makeBid(int i, Order &o) const {
+    const double INF = std::numeric_limits<double>::max();
+    double t[BLOCK];
+    double xi = _x[i];
+    double yi = _y[i];
+
+    // The K + 1 sinks with the cheapest cost plus entry price, sorted
+    double top_t[K + 1] = {INF};
+    int top_k[K + 1];
+    int cnt = 0;
+    double bound = INF;
+
+    // Visit the blocks outwards from the position of the source on the
+    // Morton curve, skipping the ones that cannot improve the candidates
+    int m = int(_sinks.size());
+    int nb = int(_block_entry.size());
+    int b0 = int(std::lower_bound(_sink_key.begin(), _sink_key.end(),
+                                  mortonKey(i)) -
+                 _sink_key.begin()) /
+             BLOCK;
+    b0 = (std::min)(b0, nb - 1);
+    for (int d = 0; d < 2 * nb; ++d) {
+      int b = (d % 2 == 0 ? b0 + d / 2 : b0 - (d + 1) / 2);
+      if (b < 0 || b >= nb)
+        continue;
+      double bx = (std::max)(0.0, (std::max)(_block_x0[b] - xi, xi - _block_x1[b]));
+      double by = (std::max)(0.0, (std::max)(_block_y0[b] - yi, yi - _block_y1[b]));
+      if (std::sqrt(bx * bx + by * by) + _block_entry[b] >= bound)
+        continue;
+
+      int k0 = b * BLOCK;
+      int len = (std::min)(BLOCK, m - k0);
+      const double *sx = &_sink_x[k0];
+      const double *sy = &_sink_y[k0];
+      const double *e = &_entry[k0];
+      double t_min = INF;
+      for (int k = 0; k < BLOCK; ++k) {
+        double dx = xi - sx[k];
+        double dy = yi - sy[k];
+        t[k] = std::sqrt(dx * dx + dy * dy) + e[k];
+        t_min = (std::min)(t_min, t[k]);
+      }
+      if (t_min >= bound)
+        continue;
+      for (int k = 0; k < len; ++k) {
+        if (t[k] < bound) {
+          int h = (std::min)(cnt, K);
+          for (; h > 0 && top_t[h - 1] > t[k]; --h) {
+            top_t[h] = top_t[h - 1];
+            top_k[h] = top_k[h - 1];
+          }
+          top_t[h] = t[k];
+          top_k[h] = k0 + k;
+          cnt = (std::min)(cnt + 1, K + 1);
+          if (cnt == K + 1)
+            bound = top_t[K];
+        }
+      }
+    }
+    // Every sink beyond the candidates costs at least cap
+    double cap = (cnt == K + 1 ? top_t[K] : INF);
+
+    // Offers of the candidates, sorted by cost plus price. The entry price
+    // of a sink is the price of the offer, unless the lowest bid of the
+    // sink belongs to the source
+    double off_t[K], off_next[K];
+    int off_k[K];
+    Value off_a[K];
+    int c = 0;
+    for (int r = 0; r < cnt && r < K; ++r) {
+      int k = top_k[r];
+      double d = top_t[r] - _entry[k];
+      double price, next;
+      Value amount;
+      offer(i, k, price, amount, next);
+      if (amount == 0)
+        continue;
+      int h = c++;
+      for (; h > 0 && off_t[h - 1] > d + price; --h) {
+        off_t[h] = off_t[h - 1];
+        off_next[h] = off_next[h - 1];
+        off_k[h] = off_k[h - 1];
+        off_a[h] = off_a[h - 1];
+      }
+      off_t[h] = d + price;
+      off_next[h] = (next == INF ? INF : d + next);
+      off_k[h] = k;
+      off_a[h] = amount;
+    }
+
+    // Take the cheapest offers
+    Value need = _left[i];
+    double next_level = INF;
+    double lambda = (std::min)(cap, c > 0 ? off_t[0] : INF);
+    o.count = 0;
+    for (int r = 0; r < c; ++r) {
+      if (off_t[r] > next_level || off_t[r] > cap) {
+        lambda = (std::min)(off_t[r], (std::min)(next_level, cap));
+        break;
+      }
+      Value x = (std::min)(need, off_a[r]);
+      o.sink[o.count] = off_k[r];
+      o.amount[o.count] = x;
+      o.count++;
+      need -= x;
+      next_level = (std::min)(next_level, off_next[r]);
+      lambda = (std::min)(next_level, cap);
+      if (need == 0) {
+        if (x < off_a[r])
+          lambda = off_t[r];
+        else if (r + 1 < c)
+          lambda = (std::min)(lambda, off_t[r + 1]);
+        break;
+      }
+    }
+    // No other option: raise the price by epsilon
+    if (lambda == INF)
+      lambda = (o.count > 0 ? off_t[o.count - 1] : top_t[0]);
+    o.lambda = lambda;
+
+    // Raise the lowest bids of the source that are below lambda
+    for (int r = 0; r < cnt && r < K; ++r) {
+      int k = top_k[r];
+      if (top_t[r] <= lambda && _bids[k].size() > 0 &&
+          _held[k] == -_supply[_n + _sinks[k]] &&
+          _bids[k].front().source == i) {
+        int h = 0;
+        while (h < o.count && o.sink[h] != k)
+          h++;
+        if (h == o.count) {
+          o.sink[o.count] = k;
+          o.amount[o.count] = 0;
+          o.count++;
+        }
+      }
+    }
+  }
+
+  // Cheapest offer of sink k to source i, with its price and mass, and a
+  // lower bound on the price of the next offer: the free mass of the sink,
+  // or its lowest bid that does not belong to the source. The heap keeps a
+  // single bid per source, so the lowest bid of another source is either
+  // the first one or one of its two children
+  void offer(int i, int k, double &price, Value &amount, double &next) const {
+    const std::vector<Bid> &heap = _bids[k];
+    const double INF = std::numeric_limits<double>::max();
+    int h = int(heap.size());
+    Value demand = -_supply[_n + _sinks[k]];
+    if (_held[k] < demand) {
+      price = _entry[k];
+      amount = demand - _held[k];
+      next = (h > 0 ? heap[0].price : INF);
+      return;
+    }
+    auto at = [&heap, h, INF](int p) { return p < h ? heap[p].price : INF; };
+    int p = 0;
+    next = (std::min)(at(1), at(2));
+    if (heap[0].source == i) {
+      p = (at(1) <= at(2) ? 1 : 2);
+      next = (std::min)(at(3 - p), (std::min)(at(2 * p + 1), at(2 * p + 2)));
+    }
+    price = at(p);
+    amount = (p < h ? heap[p].amount : 0);
+  }
+
+  // Apply the bid of source i. The prices may have risen after the bid was
+  // made: every sink sells its cheapest units that are below the price of
+  // the bid, up to the planned amount, and the units stay epsilon-optimal
+  // since no price ever decreases.
+  void bid(int i, const Order &o, IntVector &active,
+           std::vector<char> &in_queue) {
+    for (int r = 0; r < o.count; ++r) {
+      int k = o.sink[r];
+      std::vector<Bid> &heap = _bids[k];
+      Value demand = -_supply[_n + _sinks[k]];
+      double price = o.lambda - dist(i, k) + _epsilon;
+      Value want = (std::min)(o.amount[r], _left[i]);
+
+      // Take out the bid of the source, if any
+      Value mine = 0;
+      double mine_price = 0.0;
+      for (size_t h = 0; h < heap.size(); ++h)
+        if (heap[h].source == i) {
+          mine = heap[h].amount;
+          mine_price = heap[h].price;
+          heap[h] = heap.back();
+          heap.pop_back();
+          std::make_heap(heap.begin(), heap.end());
+          break;
+        }
+
+      Value got = (std::min)(want, demand - _held[k]);
+      _held[k] += got;
+      while (got < want && !heap.empty() && heap.front().price < price) {
+        Bid &low = heap.front();
+        int s = low.source;
+        Value x = (std::min)(want - got, low.amount);
+        _left[s] += x;
+        got += x;
+        if (x == low.amount) {
+          std::pop_heap(heap.begin(), heap.end());
+          heap.pop_back();
+        } else
+          low.amount -= x;
+        if (in_queue[s] == 0) {
+          active.push_back(s);
+          in_queue[s] = 1;
+        }
+      }
+
+      // The units bought join the ones of the source, at the new price
+      _left[i] -= got;
+      if (got > 0 || mine > 0) {
+        heap.emplace_back((std::max)(price, mine_price), i, mine + got);
+        std::push_heap(heap.begin(), heap.end());
+      }
+      updateSink(k);
+    }
+  }
+
+  // Entry price of sink k
+  void updateSink(int k) {
+    if (_held[k] == -_supply[_n + _sinks[k]])
+      _entry[k] = _bids[k].front().price;
+  }
+
+  // Run the auction for the current epsilon, starting from the prices of
+  // the previous phase. The first phase starts from the empty flow, the
+  // next ones keep the bids that are still epsilon-optimal
+  ProblemType phase(bool first) {
+    int m = int(_sinks.size());
+    IntVector active;
+    std::vector<char> in_queue(_n, 0);
+    if (first) {
+      for (int k = 0; k < m; ++k) {
+        _held[k] = 0;
+        _bids[k].clear();
+      }
+      for (int i : _sources)
+        _left[i] = _supply[i];
+    } else {
+      // Cheapest cost plus price of every source
+      DoubleVector u(_n, 0.0);
+      int s = int(_sources.size());
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(_threads) if (s > 64)
+#endif
+      for (int h = 0; h < s; ++h) {
+        int i = _sources[h];
+        double c = std::numeric_limits<double>::max();
+        for (int k = 0; k < m; ++k)
+          c = (std::min)(c, dist(i, k) + _entry[k]);
+        u[i] = c;
+      }
+
+      // Release the bids that are not epsilon-optimal: the free mass of a
+      // sink keeps its lowest price, so the entry prices do not change
+      for (int k = 0; k < m; ++k) {
+        std::vector<Bid> &heap = _bids[k];
+        size_t kept = 0;
+        for (size_t h = 0; h < heap.size(); ++h) {
+          const Bid &b = heap[h];
+          if (dist(b.source, k) + b.price <= u[b.source] + _epsilon)
+            heap[kept++] = b;
+          else {
+            _left[b.source] += b.amount;
+            _held[k] -= b.amount;
+          }
+        }
+        heap.resize(kept, Bid(0, 0, 0));
+        std::make_heap(heap.begin(), heap.end());
+        updateSink(k);
+      }
+    }
+    for (int i : _sources)
+      if (_left[i] > 0) {
+        active.push_back(i);
+        in_queue[i] = 1;
+      }
+
+    std::vector<Order> orders;
+    ProblemType status;
+    while (!active.empty()) {
+      if (interrupted(status))
+        return status;
+
+      // The entry prices only rise, so the lowest entry of a block is
+      // updated once per round
+      for (size_t b = 0; b < _block_entry.size(); ++b)
+        _block_entry[b] = *std::min_element(&_entry[b * BLOCK],
+                                            &_entry[b * BLOCK] + BLOCK);
+
+      // Bidding: every active source looks for its best sinks
+      int a = int(active.size());
+      orders.resize(a);
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(_threads) schedule(dynamic, 16) if (a > 64)
+#endif
+      for (int h = 0; h < a; ++h)
+        makeBid(active[h], orders[h]);
+
+      // Assignment: the bids are applied in order
+      IntVector round;
+      round.swap(active);
+      for (int i : round)
+        in_queue[i] = 0;
+      for (int h = 0; h < a; ++h) {
+        int i = round[h];
+        if (_left[i] > 0)
+          bid(i, orders[h], active, in_queue);
+        if (_left[i] > 0 && in_queue[i] == 0) {
+          active.push_back(i);
+          in_queue[i] = 1;
+        }
+      }
+      _iterations += a;
+    }
+
+    return ProblemType::OPTIMAL;
+  }
+
+  // Cost of the flow, and dual bound of the prices: every source pays the
+  // cheapest cost plus price, every sink refunds its price
+  void computeBounds() {
+    int m = int(_sinks.size());
+    double primal = 0.0;
+    for (int k = 0; k < m; ++k)
+      for (const Bid &b : _bids[k])
+        primal += double(b.amount) * dist(b.source, k);
+
+    double dual = 0.0;
+    int s = int(_sources.size());
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(_threads) reduction(+ : dual)
+#endif
+    for (int h = 0; h < s; ++h) {
+      int i = _sources[h];
+      double u = std::numeric_limits<double>::max();
+      for (int k = 0; k < m; ++k)
+        u = (std::min)(u, dist(i, k) + _entry[k]);
+      dual += double(_supply[i]) * u;
+    }
+    for (int k = 0; k < m; ++k)
+      dual += double(_supply[_n + _sinks[k]]) * _entry[k];
+
+    _primal = primal;
+    _dual = dual;
+  }
+};
+
+template <typename V> const int Auction<V>::ALPHA;
+template <typename V> const int Auction<V>::K;
+template <typename V> const int Auction<V>::BLOCK;
+} // namespace KWD
@@ -0,0 +1,464 @@
+/**
+ * @fileoverview Copyright (c) 2019-2021, Stefano Gualandi,
+ *               via Ferrata, 1, I-27100, Pavia, Italy
+ *
+ * @author stefano.gualandi@gmail.com (Stefano Gualandi)
+ *
+ */
+
+// ORIGINAL SOURCE CODE FOR THE COST SCALING ALGORITHM TAKE FROM:
+// WEBSITE: https://lemon.cs.elte.hu
+
+/* ORIGINAL LICENSE FILE:
+ * This file is a part of LEMON, a generic C++ optimization library.
+ *
+ * Copyright (C) 2003-2013
+ * Egervary Jeno Kombinatorikus Optimalizalasi Kutatocsoport
+ * (Egervary Research Group on Combinatorial Optimization, EGRES).
+ *
+ * Permission to use, modify and distribute this software is granted
+ * provided that this copyright notice appears in all copies. For
+ * precise terms see the accompanying LICENSE file.
+ *
+ * This software is provided "AS IS" with no warranty of any kind,
+ * express or implied, and with no claim as to its suitability for any
+ * purpose.
+ *
+ */
+
+#pragma once
+
+#include "KWD_NetSimplex.h"
+
+namespace KWD {
+
+// Cost scaling push-relabel algorithm for the min cost flow problem with
+// uncapacitated arcs, as the networks of the Solver. Supplies and costs
+// must be integers: the costs are multiplied by the number of nodes, so
+// that an epsilon-optimal flow with epsilon = 1 is optimal. Every phase
+// divides epsilon by ALPHA and restores the epsilon-optimality of the
+// flow pushing the excesses along admissible arcs (the push method of
+// LEMON), with a global update of the potentials before every phase.
+template <typename V = int64_t, typename C = int64_t> class CostScaling {
+public:
+  // The type of the flow amounts and supply values
+  typedef V Value;
+  // The type of the arc costs
+  typedef C Cost;
+
+  // Scaling factor of epsilon between two phases
+  static const int ALPHA = 16;
+
+  // Largest absolute cost allowed on a network with node_num nodes: the
+  // potentials stay within a few times node_num^2 times the largest cost
+  static double maxCost(int node_num) {
+    double n = double(node_num) + 1;
+    return double((std::numeric_limits<Cost>::max)()) / 32 / (n * n);
+  }
+
+private:
+  typedef std::vector<int> IntVector;
+  typedef std::vector<Value> ValueVector;
+  typedef std::vector<Cost> CostVector;
+
+  // Input network
+  int _node_num;
+  ValueVector _supply;
+  IntVector _source;
+  IntVector _target;
+  CostVector _cost;
+
+  // Residual network: the residual arcs of node u are the ones from
+  // _first_out[u] to _first_out[u + 1], an arc and its reverse are paired
+  IntVector _first_out;
+  IntVector _res_target;
+  IntVector _reverse;
+  CostVector _res_cost;
+  ValueVector _res_cap;
+  // Forward residual arc of every arc
+  IntVector _arc_idx;
+
+  // Node data
+  ValueVector _excess;
+  CostVector _pi;
+  IntVector _next_out;
+
+  // Queue of the active nodes
+  IntVector _active;
+  std::vector<char> _in_queue;
+
+  // Buckets of the global update (doubly linked lists)
+  IntVector _bucket_next;
+  IntVector _bucket_prev;
+  IntVector _bucket_first;
+  IntVector _rank;
+
+  Cost _epsilon;
+  Cost _pi_min;
+
+  double _runtime;
+  double _timelimit;
+  std::chrono::steady_clock::time_point _deadline;
+  const CancelToken *_cancel;
+  std::string _verbosity;
+
+  uint64_t _iterations;
+
+public:
+  CostScaling(int node_num, int arc_num)
+      : _node_num(node_num), _epsilon(1), _pi_min(0), _runtime(0.0),
+        _timelimit(std::numeric_limits<double>::max()),
+        _deadline(deadlineAfter(std::numeric_limits<double>::max())),
+        _cancel(nullptr), _verbosity(KWD_VAL_INFO), _iterations(0) {
+    // Check the number types
+    if (std::numeric_limits<Value>::is_exact == false ||
+        std::numeric_limits<Cost>::is_exact == false)
+      throw std::runtime_error(
+          "The flow and cost types of CostScaling must be integers");
+
+    _supply.resize(_node_num, 0);
+    _source.reserve(arc_num);
+    _target.reserve(arc_num);
+    _cost.reserve(arc_num);
+  }
+
+  // Set the supply of node i
+  void addNode(int i, Value b) { _supply[i] = b; }
+
+  // Add the arc (a, b) with cost c, and return its id
+  size_t addArc(int a, int b, Cost c) {
+    _source.push_back(a);
+    _target.push_back(b);
+    _cost.push_back(c);
+    _first_out.clear(); // the residual network must be rebuilt
+    return _source.size() - 1;
+  }
+
+  void setArcCost(size_t e, Cost c) {
+    _cost[e] = c;
+    if (!_first_out.empty()) {
+      int f = _arc_idx[e];
+      _res_cost[f] = c * (Cost(_node_num) + 1);
+      _res_cost[_reverse[f]] = -_res_cost[f];
+    }
+  }
+
+  void setTimelimit(double t) {
+    _timelimit = t;
+    _deadline = deadlineAfter(t);
+    PRINT("INFO: change <timelimit> to %f\n", t);
+  }
+  void setCancelToken(const CancelToken *token) { _cancel = token; }
+  void setVerbosity(std::string v) {
+    _verbosity = v;
+    PRINT("INFO: change <verbosity> to %s\n", v.c_str());
+  }
+
+  double runtime() const { return _runtime; }
+
+  // Number of relabel operations
+  uint64_t iterations() const { return _iterations; }
+
+  size_t num_nodes() const { return _node_num; }
+  size_t num_arcs() const { return _source.size(); }
+
+  // Flow on arc e
+  Value flow(size_t e) const { return _res_cap[_reverse[_arc_idx[e]]]; }
+
+  // Total cost of the flow, accumulated in the given number type
+  template <typename Number = double> Number totalCost() const {
+    Number c = 0;
+    for (size_t e = 0; e < _source.size(); ++e)
+      c += Number(flow(e)) * Number(_cost[e]);
+    return c;
+  }
+
+  ProblemType run() {
+    auto start_t = std::chrono::steady_clock::now();
+    _iterations = 0;
+
+    Value sum_supply = 0;
+    Value max_supply = 0;
+    for (int u = 0; u < _node_num; ++u) {
+      sum_supply += _supply[u];
+      if (_supply[u] > 0)
+        max_supply += _supply[u];
+    }
+    if (sum_supply != 0)
+      return ProblemType::INFEASIBLE;
+
+    if (_first_out.empty())
+      buildResidual();
+    init(max_supply);
+
+    ProblemType status = ProblemType::OPTIMAL;
+    while (_epsilon > 1) {
+      _epsilon = (std::max)(Cost(1), _epsilon / ALPHA);
+      status = refine();
+      if (status != ProblemType::OPTIMAL)
+        break;
+      if (_verbosity == KWD_VAL_DEBUG)
+        PRINT("CostScaling phase | epsilon: %ld, relabels: %ld\n",
+              (long)_epsilon, (long)_iterations);
+    }
+
+    auto end_t = std::chrono::steady_clock::now();
+    _runtime = double(std::chrono::duration_cast<std::chrono::milliseconds>(
+                          end_t - start_t)
+                          .count()) /
+               1000;
+    return status;
+  }
+
+private:
+  // Build the residual network: the costs are multiplied by the number of
+  // nodes, and the residual arcs are sorted by source node
+  void buildResidual() {
+    int m = int(_source.size());
+    _first_out.assign(_node_num + 1, 0);
+    for (int e = 0; e < m; ++e) {
+      _first_out[_source[e] + 1]++;
+      _first_out[_target[e] + 1]++;
+    }
+    for (int u = 0; u < _node_num; ++u)
+      _first_out[u + 1] += _first_out[u];
+
+    _res_target.resize(2 * m);
+    _reverse.resize(2 * m);
+    _res_cost.resize(2 * m);
+    _res_cap.resize(2 * m);
+    _arc_idx.resize(m);
+
+    Cost scale = Cost(_node_num) + 1;
+    IntVector pos(_first_out.begin(), _first_out.end() - 1);
+    for (int e = 0; e < m; ++e) {
+      int f = pos[_source[e]]++;
+      int b = pos[_target[e]]++;
+      _res_target[f] = _target[e];
+      _res_target[b] = _source[e];
+      _reverse[f] = b;
+      _reverse[b] = f;
+      _res_cost[f] = _cost[e] * scale;
+      _res_cost[b] = -_cost[e] * scale;
+      _arc_idx[e] = f;
+    }
+  }
+
+  // Start from the empty flow and null potentials, which are epsilon-optimal
+  // for epsilon equal to the largest cost
+  void init(Value max_supply) {
+    int m = int(_source.size());
+    _epsilon = 1;
+    for (int e = 0; e < m; ++e) {
+      int f = _arc_idx[e];
+      _res_cap[f] = max_supply; // no arc carries more than all the supply
+      _res_cap[_reverse[f]] = 0;
+      _epsilon = (std::max)(_epsilon, _res_cost[f] < 0 ? -_res_cost[f]
+                                                       : _res_cost[f]);
+    }
+
+    _excess.assign(_supply.begin(), _supply.end());
+    _pi.assign(_node_num, 0);
+    _next_out.resize(_node_num);
+    _in_queue.assign(_node_num, 0);
+    _active.clear();
+
+    // A node never drops below this potential on a feasible network
+    _pi_min = -4 * (Cost(_node_num) + 1) * _epsilon;
+  }
+
+  // Check the deadline and the cancel token
+  bool interrupted(ProblemType &status) const {
+    if (_cancel != nullptr && _cancel->cancelled()) {
+      status = ProblemType::CANCELLED;
+      return true;
+    }
+    if (std::chrono::steady_clock::now() > _deadline) {
+      status = ProblemType::TIMELIMIT;
+      return true;
+    }
+    return false;
+  }
+
+  // Make the flow epsilon-optimal for the current epsilon
+  ProblemType refine() {
+    // Saturate the arcs with negative reduced cost
+    for (int u = 0; u < _node_num; ++u) {
+      for (int r = _first_out[u]; r < _first_out[u + 1]; ++r) {
+        Value delta = _res_cap[r];
+        if (delta > 0) {
+          int v = _res_target[r];
+          if (_res_cost[r] + _pi[u] - _pi[v] < 0) {
+            _excess[u] -= delta;
+            _excess[v] += delta;
+            _res_cap[r] = 0;
+            _res_cap[_reverse[r]] += delta;
+          }
+        }
+      }
+    }
+
+    globalUpdate();
+
+    for (int u = 0; u < _node_num; ++u) {
+      _next_out[u] = _first_out[u];
+      if (_excess[u] > 0) {
+        _active.push_back(u);
+        _in_queue[u] = 1;
+      }
+    }
+
+    // Discharge the active nodes in FIFO order, repeating the global update
+    // every node_num relabels
+    ProblemType status;
+    uint64_t next_update = _iterations + uint64_t(_node_num);
+    size_t head = 0;
+    while (head < _active.size()) {
+      int u = _active[head++];
+      _in_queue[u] = 0;
+
+      while (_excess[u] > 0) {
+        // Push along the admissible arcs
+        int r = _next_out[u];
+        int r_end = _first_out[u + 1];
+        for (; r < r_end && _excess[u] > 0; ++r) {
+          if (_res_cap[r] > 0) {
+            int v = _res_target[r];
+            if (_res_cost[r] + _pi[u] - _pi[v] < 0) {
+              Value delta = (std::min)(_res_cap[r], _excess[u]);
+              _res_cap[r] -= delta;
+              _res_cap[_reverse[r]] += delta;
+              _excess[u] -= delta;
+              _excess[v] += delta;
+              if (_excess[v] > 0 && _in_queue[v] == 0) {
+                _active.push_back(v);
+                _in_queue[v] = 1;
+              }
+              if (_excess[u] == 0)
+                break;
+            }
+          }
+        }
+        _next_out[u] = r;
+        if (_excess[u] == 0)
+          break;
+
+        // Relabel: the cheapest residual arc becomes admissible
+        Cost min_red_cost = (std::numeric_limits<Cost>::max)();
+        for (r = _first_out[u]; r < r_end; ++r) {
+          if (_res_cap[r] > 0) {
+            Cost c = _res_cost[r] + _pi[u] - _pi[_res_target[r]];
+            if (c < min_red_cost)
+              min_red_cost = c;
+          }
+        }
+        if (min_red_cost == (std::numeric_limits<Cost>::max)())
+          return ProblemType::INFEASIBLE;
+        _pi[u] -= min_red_cost + _epsilon;
+        _next_out[u] = _first_out[u];
+        if (_pi[u] < _pi_min)
+          return ProblemType::INFEASIBLE;
+
+        _iterations++;
+        if (_iterations % CHECK_INTERVAL == 0 && interrupted(status))
+          return status;
+
+        if (_iterations >= next_update) {
+          globalUpdate();
+          for (int w = 0; w < _node_num; ++w)
+            _next_out[w] = _first_out[w];
+          next_update = _iterations + uint64_t(_node_num);
+        }
+      }
+
+      // Compact the queue
+      if (head > 4096 && 2 * head > _active.size()) {
+        _active.erase(_active.begin(), _active.begin() + head);
+        head = 0;
+      }
+    }
+    _active.clear();
+
+    return ProblemType::OPTIMAL;
+  }
+
+  // Global update heuristic: lower the potentials of the nodes by the
+  // length, in units of epsilon, of their shortest path towards a node
+  // with a deficit in the residual network, so that every excess has an
+  // admissible path to a deficit
+  void globalUpdate() {
+    const int MAX_RANK = 4 * _node_num;
+    _rank.assign(_node_num, MAX_RANK + 1);
+    _bucket_next.assign(_node_num, -1);
+    _bucket_prev.assign(_node_num, -1);
+    _bucket_first.assign(MAX_RANK + 2, -1);
+
+    int excess_nodes = 0;
+    for (int u = 0; u < _node_num; ++u) {
+      if (_excess[u] < 0) {
+        _rank[u] = 0;
+        bucketInsert(u, 0);
+      } else if (_excess[u] > 0)
+        excess_nodes++;
+    }
+    if (excess_nodes == 0)
+      return;
+
+    // Dial's algorithm with arc lengths floor(reduced cost / epsilon) + 1,
+    // on the residual arcs entering the scanned node
+    int r_max = 0;
+    for (int k = 0; k <= MAX_RANK && excess_nodes > 0; ++k) {
+      while (_bucket_first[k] >= 0 && excess_nodes > 0) {
+        int v = _bucket_first[k];
+        bucketRemove(v, k);
+        _rank[v] = -k - 1; // scanned
+        r_max = k;
+        if (_excess[v] > 0)
+          excess_nodes--;
+
+        // The residual arcs (u, v) are the reverse of the arcs of v
+        for (int r = _first_out[v]; r < _first_out[v + 1]; ++r) {
+          int u = _res_target[r];
+          int ru = _reverse[r];
+          if (_rank[u] < 0 || _res_cap[ru] == 0)
+            continue;
+          Cost c = _res_cost[ru] + _pi[u] - _pi[v];
+          Cost l = c < 0 ? 0 : c / _epsilon + 1;
+          if (l > MAX_RANK - k)
+            continue;
+          int nk = k + int(l);
+          if (nk < _rank[u]) {
+            if (_rank[u] <= MAX_RANK)
+              bucketRemove(u, _rank[u]);
+            _rank[u] = nk;
+            bucketInsert(u, nk);
+          }
+        }
+      }
+    }
+
+    // The nodes not scanned are at least as far as the last scanned one
+    for (int u = 0; u < _node_num; ++u) {
+      int k = _rank[u] < 0 ? -_rank[u] - 1 : r_max;
+      _pi[u] -= Cost(k) * _epsilon;
+    }
+  }
+
+  void bucketInsert(int u, int k) {
+    _bucket_prev[u] = -1;
+    _bucket_next[u] = _bucket_first[k];
+    if (_bucket_first[k] >= 0)
+      _bucket_prev[_bucket_first[k]] = u;
+    _bucket_first[k] = u;
+  }
+
+  void bucketRemove(int u, int k) {
+    if (_bucket_prev[u] >= 0)
+      _bucket_next[_bucket_prev[u]] = _bucket_next[u];
+    else
+      _bucket_first[k] = _bucket_next[u];
+    if (_bucket_next[u] >= 0)
+      _bucket_prev[_bucket_next[u]] = _bucket_prev[u];
+  }
+};
+} // namespace KWD
@@ -29,8 +29,12 @@ using std::unordered_set;
 #include <exception>
 #include <fstream>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <sstream>
 #include <string>
+#include <typeindex>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -57,20 +61,27 @@ void tolower(std::string &data) {
 // List of solver parameters:
 //------------------------------
 
-// (exact, approx)
+// (exact, approx, multiscale)
 constexpr auto KWD_PAR_METHOD = "Method";
 constexpr auto KWD_VAL_EXACT = "exact";
 constexpr auto KWD_VAL_APPROX = "approx";
+constexpr auto KWD_VAL_MULTISCALE = "multiscale";
+// Multiscale: side of the coarsest level of the pyramid
+constexpr int KWD_MULTISCALE_COARSEST = 64;
 
 // (bipartite, mincostflow)
 constexpr auto KWD_PAR_MODEL = "Model";
 constexpr auto KWD_VAL_BIPARTITE = "bipartite";
 constexpr auto KWD_VAL_MINCOSTFLOW = "mincostflow";
 
-// (fullmodel, colgen)
+// (fullmodel, colgen, costscaling, auction)
 constexpr auto KWD_PAR_ALGORITHM = "Algorithm";
 constexpr auto KWD_VAL_FULLMODEL = "fullmodel";
 constexpr auto KWD_VAL_COLGEN = "colgen";
+constexpr auto KWD_VAL_COSTSCALING = "costscaling";
+// Auction algorithm on the bipartite model of compareExact, without
+// storing the arcs
+constexpr auto KWD_VAL_AUCTION = "auction";
 
 // ('SILENT', 'INFO', 'DEBUG')
 constexpr auto KWD_PAR_VERBOSITY = "Verbosity";
@@ -80,18 +91,68 @@ constexpr auto KWD_VAL_DEBUG = "debug";
 
 constexpr auto KWD_PAR_TIMELIMIT = "TimeLimit";
 constexpr auto KWD_PAR_OPTTOLERANCE = "OptTolerance";
+// Number of threads used by the network simplex to price the arcs
+constexpr auto KWD_PAR_THREADS = "Threads";
+// Number of threads that solve the targets of a batch comparison, each with
+// its own network simplex
+constexpr auto KWD_PAR_BATCHTHREADS = "BatchThreads";
+
+// Column generation: columns added per node at every round, and rounds
+// that a column spends out of the basis before it can be replaced
+constexpr auto KWD_PAR_POOLCOLUMNS = "PoolColumns";
+constexpr auto KWD_PAR_POOLAGE = "PoolAge";
+// Largest number of columns per node
+constexpr int KWD_MAX_POOL_COLUMNS = 16;
 
 constexpr auto KWD_PAR_RECODE = "Recode";
 
 constexpr auto KWD_PAR_UNBALANCED = "Unbalanced";
 constexpr auto KWD_PAR_UNBALANCED_COST = "UnbalancedCost";
+// Unbalanced transport with capacities on the arcs of the virtual node,
+// instead of big-M costs (true, false)
+constexpr auto KWD_PAR_CAPACITATED = "Capacitated";
 constexpr auto KWD_PAR_CONVEXHULL = "ConvexHull";
 
+// (none, primal, dual): reuse the previous basis in batched comparisons
+constexpr auto KWD_PAR_WARMSTART = "WarmStart";
+constexpr auto KWD_VAL_NONE = "none";
+constexpr auto KWD_VAL_PRIMAL = "primal";
+constexpr auto KWD_VAL_DUAL = "dual";
+
+// Pivot rule of the network simplex
+constexpr auto KWD_PAR_PIVOTRULE = "PivotRule";
+constexpr auto KWD_VAL_BLOCKSEARCH = "blocksearch";
+constexpr auto KWD_VAL_CANDIDATELIST = "candidatelist";
+constexpr auto KWD_VAL_ALTERINGLIST = "alteringlist";
+constexpr auto KWD_VAL_ADAPTIVEBLOCK = "adaptiveblock";
+
+// Do not store the arcs of the L-approximation graph (true, false)
+constexpr auto KWD_PAR_IMPLICITARCS = "ImplicitArcs";
+
+// Number type of flows and costs in the network simplex
+constexpr auto KWD_PAR_PRECISION = "Precision";
+constexpr auto KWD_VAL_DOUBLE = "double";
+constexpr auto KWD_VAL_SINGLE = "single";
+constexpr auto KWD_VAL_INTEGER = "integer";
+
+// Total mass of the supplies in integer precision
+constexpr int64_t KWD_INTEGER_MASS = int64_t(1) << 40;
+
+// Numbering of the nodes of the network models
+constexpr auto KWD_PAR_NODEORDER = "NodeOrder";
+constexpr auto KWD_VAL_INPUT = "input";
+constexpr auto KWD_VAL_MORTON = "morton";
+constexpr auto KWD_VAL_HILBERT = "hilbert";
+
 constexpr auto KWD_VAL_TRUE = "true";
 constexpr auto KWD_VAL_FALSE = "false";
 
 // My Network Simplex
 #include "KWD_NetSimplex.h"
+#include "KWD_NetSimplexGrid.h"
+#include "KWD_NetSimplexCapacity.h"
+#include "KWD_CostScaling.h"
+#include "KWD_Auction.h"
 
 struct coprimes_t {
 public:
@@ -101,6 +162,135 @@ public:
   double c_vw;
 };
 
+// Number of direction tables kept in the process-wide cache
+constexpr size_t KWD_COPRIMES_CACHE = 8;
+
+// Table of the directions (v, w) with gcd(v, w) = 1 and |v|, |w| <= L,
+// with their cost: the tables are cached per L and shared by all the
+// solvers, and they are read-only
+class CoprimeTable {
+public:
+  typedef std::vector<coprimes_t> Vector;
+  typedef Vector::const_iterator const_iterator;
+
+  CoprimeTable() : _table(std::make_shared<Data>()) {}
+
+  // Table for L, built once per process
+  static CoprimeTable get(int L) {
+    static std::mutex mtx;
+    static std::map<int, std::shared_ptr<const Data>> cache;
+
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = cache.find(L);
+    if (it != cache.end())
+      return CoprimeTable(it->second);
+
+    auto table = build(L);
+    // The solvers keep their own reference to the evicted tables
+    if (cache.size() >= KWD_COPRIMES_CACHE)
+      cache.clear();
+    cache[L] = table;
+    return CoprimeTable(table);
+  }
+
+  const_iterator begin() const { return _table->dirs.begin(); }
+  const_iterator end() const { return _table->dirs.end(); }
+  size_t size() const { return _table->dirs.size(); }
+  const coprimes_t &operator[](size_t i) const { return _table->dirs[i]; }
+
+  // Largest |v| and |w| of the directions
+  int maxStep() const { return _table->L; }
+
+  // Directions of the row v, with w increasing from -L to L
+  const_iterator rowBegin(int v) const {
+    return begin() + _table->first[v + _table->L];
+  }
+  const_iterator rowEnd(int v) const {
+    return begin() + _table->first[v + _table->L + 1];
+  }
+
+private:
+  // Directions, and first direction of every row v, from -L to L
+  struct Data {
+    Data() : L(0), first(2, 0) {}
+    int L;
+    Vector dirs;
+    std::vector<size_t> first;
+  };
+
+  explicit CoprimeTable(std::shared_ptr<const Data> table)
+      : _table(std::move(table)) {}
+
+  // Sieve of the coprime pairs of the quadrant 0 <= a, b <= L: b is coprime
+  // with a if no prime factor of a divides b. The directions are listed by
+  // v and then by w, from -L to L
+  static std::shared_ptr<const Data> build(int L) {
+    auto table = std::make_shared<Data>();
+    if (L <= 0)
+      return table;
+
+    size_t W = size_t(L) + 1;
+
+    // Smallest prime factor of every number up to L
+    std::vector<int> spf(W, 0);
+    for (int i = 2; i <= L; ++i)
+      if (spf[i] == 0)
+        for (int j = i; j <= L; j += i)
+          if (spf[j] == 0)
+            spf[j] = i;
+
+    std::vector<char> C(W * W, 1);
+    // Directions of every row v >= 0, counted on both sides of w = 0
+    std::vector<size_t> cnt(W, 0);
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 16) if (L >= 256)
+#endif
+    for (int a = 0; a <= L; ++a) {
+      char *row = &C[size_t(a) * W];
+      if (a == 0) {
+        std::fill(row, row + W, 0);
+        row[1] = 1;
+      }
+      for (int x = a; x > 1;) {
+        int p = spf[x];
+        for (int b = 0; b <= L; b += p)
+          row[b] = 0;
+        while (x % p == 0)
+          x /= p;
+      }
+      size_t c = row[0];
+      for (int b = 1; b <= L; ++b)
+        c += 2 * size_t(row[b]);
+      cnt[a] = c;
+    }
+
+    // First direction of every row v, from -L to L
+    std::vector<size_t> &first = table->first;
+    first.assign(2 * W, 0);
+    for (int v = -L; v <= L; ++v)
+      first[v + L + 1] = first[v + L] + cnt[std::abs(v)];
+    table->L = L;
+    table->dirs.resize(first[2 * W - 1], coprimes_t(0, 0, 0.0));
+
+    Vector &T = table->dirs;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 16) if (L >= 256)
+#endif
+    for (int v = -L; v <= L; ++v) {
+      const char *row = &C[size_t(std::abs(v)) * W];
+      size_t k = first[v + L];
+      for (int w = -L; w <= L; ++w)
+        if (row[std::abs(w)])
+          T[k++] = coprimes_t(v, w, sqrt(double(v) * v + double(w) * w));
+    }
+
+    return table;
+  }
+
+  std::shared_ptr<const Data> _table;
+};
+
 typedef std::pair<int, int> int_pair;
 
 struct pair_hash {
@@ -279,7 +469,7 @@ public:
       add(other.getX(i), other.getY(i), other.getB(i));
   }
 
-  double balance() {
+  double balance() const {
     double t = 0;
     for (size_t i = 0, i_max = B.size(); i < i_max; ++i)
       t += B[i];
@@ -307,7 +497,72 @@ public:
     return M;
   }
 
+  // Renumber the points along a space filling curve (morton, hilbert), so
+  // that close points get close indices. Any other order keeps the input
+  void reorder(const std::string &order) {
+    if (order != KWD_VAL_MORTON && order != KWD_VAL_HILBERT)
+      return;
+    size_t n = X.size();
+    if (n < 2)
+      return;
+
+    int xmin = *std::min_element(X.begin(), X.end());
+    int ymin = *std::min_element(Y.begin(), Y.end());
+    uint64_t side = 1;
+    for (size_t i = 0; i < n; ++i)
+      while (uint64_t(X[i] - xmin) >= side || uint64_t(Y[i] - ymin) >= side)
+        side *= 2;
+
+    std::vector<std::pair<uint64_t, size_t>> K(n);
+    for (size_t i = 0; i < n; ++i) {
+      uint64_t x = uint64_t(X[i] - xmin);
+      uint64_t y = uint64_t(Y[i] - ymin);
+      K[i] = {order == KWD_VAL_MORTON ? mortonKey(x, y)
+                                      : hilbertKey(side, x, y),
+              i};
+    }
+    std::sort(K.begin(), K.end());
+
+    std::vector<int> X2(n), Y2(n);
+    std::vector<double> B2(n);
+    for (size_t i = 0; i < n; ++i) {
+      X2[i] = X[K[i].second];
+      Y2[i] = Y[K[i].second];
+      B2[i] = B[K[i].second];
+      M[std::make_pair(X2[i], Y2[i])] = i;
+    }
+    X.swap(X2);
+    Y.swap(Y2);
+    B.swap(B2);
+  }
+
 private:
+  // Interleave the bits of x and y
+  static uint64_t mortonKey(uint64_t x, uint64_t y) {
+    uint64_t k = 0;
+    for (int b = 0; b < 32; ++b)
+      k |= ((x >> b) & 1) << (2 * b) | ((y >> b) & 1) << (2 * b + 1);
+    return k;
+  }
+
+  // Distance of (x, y) along the Hilbert curve filling a side x side grid
+  static uint64_t hilbertKey(uint64_t side, uint64_t x, uint64_t y) {
+    uint64_t k = 0;
+    for (uint64_t s = side / 2; s > 0; s /= 2) {
+      uint64_t rx = (x & s) > 0;
+      uint64_t ry = (y & s) > 0;
+      k += s * s * ((3 * rx) ^ ry);
+      if (ry == 0) {
+        if (rx == 1) {
+          x = side - 1 - x;
+          y = side - 1 - y;
+        }
+        std::swap(x, y);
+      }
+    }
+    return k;
+  }
+
   // Point coordinates (integers)
   std::vector<int> X;
   std::vector<int> Y;
@@ -561,9 +816,16 @@ class Solver {
 public:
   // Standard c'tor
   Solver()
-      : _runtime(0.0), _n_log(0), L(-1), verbosity(KWD_VAL_INFO), recode(""),
+      : _status(ProblemType::INFEASIBLE), _runtime(0.0), _iterations(0),
+        _num_nodes(0), _num_arcs(0), _error_bound(0.0), _n_log(0), L(-1), verbosity(KWD_VAL_INFO),
+        recode(""),
         opt_tolerance(1e-06), timelimit(std::numeric_limits<double>::max()),
-        unbalanced(false), unbal_cost(std::numeric_limits<double>::max()) {}
+        threads(1), batch_threads(1),
+        unbalanced(false), unbal_cost(std::numeric_limits<double>::max()),
+        capacitated(false), pool_columns(1), pool_age(1),
+        warm_start(KWD_VAL_NONE), pivot_rule(KWD_VAL_BLOCKSEARCH),
+        implicit_arcs(false), precision(KWD_VAL_DOUBLE),
+        node_order(KWD_VAL_INPUT), cancel_token(nullptr) {}
 
   // Setter/getter for parameters
   std::string getStrParam(const std::string &name) const {
@@ -577,8 +839,20 @@ public:
       return recode;
     if (name == KWD_PAR_UNBALANCED)
       return (unbalanced ? KWD_VAL_TRUE : KWD_VAL_FALSE);
+    if (name == KWD_PAR_CAPACITATED)
+      return (capacitated ? KWD_VAL_TRUE : KWD_VAL_FALSE);
     if (name == KWD_PAR_CONVEXHULL)
       return (convex_hull ? KWD_VAL_TRUE : KWD_VAL_FALSE);
+    if (name == KWD_PAR_WARMSTART)
+      return warm_start;
+    if (name == KWD_PAR_PIVOTRULE)
+      return pivot_rule;
+    if (name == KWD_PAR_IMPLICITARCS)
+      return (implicit_arcs ? KWD_VAL_TRUE : KWD_VAL_FALSE);
+    if (name == KWD_PAR_PRECISION)
+      return precision;
+    if (name == KWD_PAR_NODEORDER)
+      return node_order;
 
     return "ERROR getStrParam: wrong parameter ->" + name;
   }
@@ -588,8 +862,16 @@ public:
       return timelimit;
     if (name == KWD_PAR_OPTTOLERANCE)
       return opt_tolerance;
+    if (name == KWD_PAR_THREADS)
+      return threads;
+    if (name == KWD_PAR_BATCHTHREADS)
+      return batch_threads;
     if (name == KWD_PAR_UNBALANCED_COST)
       return unbal_cost;
+    if (name == KWD_PAR_POOLCOLUMNS)
+      return pool_columns;
+    if (name == KWD_PAR_POOLAGE)
+      return pool_age;
     return -1;
   }
 
@@ -612,8 +894,26 @@ public:
     if (name == KWD_PAR_UNBALANCED)
       unbalanced = (value == KWD_VAL_TRUE ? true : false);
 
+    if (name == KWD_PAR_CAPACITATED)
+      capacitated = (value == KWD_VAL_TRUE ? true : false);
+
     if (name == KWD_PAR_CONVEXHULL)
       convex_hull = (value == KWD_VAL_TRUE ? true : false);
+
+    if (name == KWD_PAR_WARMSTART)
+      warm_start = value;
+
+    if (name == KWD_PAR_PIVOTRULE)
+      pivot_rule = value;
+
+    if (name == KWD_PAR_IMPLICITARCS)
+      implicit_arcs = (value == KWD_VAL_TRUE ? true : false);
+
+    if (name == KWD_PAR_PRECISION)
+      precision = value;
+
+    if (name == KWD_PAR_NODEORDER)
+      node_order = value;
   }
 
   void setDblParam(const std::string &name, double value) {
@@ -623,15 +923,30 @@ public:
     if (name == KWD_PAR_OPTTOLERANCE)
       opt_tolerance = value;
 
+    if (name == KWD_PAR_THREADS)
+      threads = (std::max)(1, int(value));
+
+    if (name == KWD_PAR_BATCHTHREADS)
+      batch_threads = (std::max)(1, int(value));
+
     if (name == KWD_PAR_UNBALANCED_COST)
       unbal_cost = value;
+
+    if (name == KWD_PAR_POOLCOLUMNS)
+      pool_columns =
+          (std::min)(KWD_MAX_POOL_COLUMNS, (std::max)(1, int(value)));
+
+    if (name == KWD_PAR_POOLAGE)
+      pool_age = (std::max)(1, int(value));
   }
 
   void dumpParam() const {
-    PRINT("Internal parameters: %s %s %s %s %.3f %f %s %d %.1f, %d\n",
+    PRINT("Internal parameters: %s %s %s %s %.3f %f %s %d %.1f, %d %s %d %s "
+          "%d %s %s\n",
           method.c_str(), model.c_str(), algorithm.c_str(), verbosity.c_str(),
           timelimit, opt_tolerance, recode.c_str(), (int)unbalanced, unbal_cost,
-          (int)convex_hull);
+          (int)convex_hull, warm_start.c_str(), threads, pivot_rule.c_str(),
+          (int)implicit_arcs, precision.c_str(), node_order.c_str());
   }
 
   // Return status of the solver
@@ -644,6 +959,8 @@ public:
       return "Unbounded";
     if (_status == ProblemType::TIMELIMIT)
       return "TimeLimit";
+    if (_status == ProblemType::CANCELLED)
+      return "Cancelled";
 
     return "Undefined";
   }
@@ -660,6 +977,19 @@ public:
   // Number of nodes in the model
   uint64_t num_nodes() const { return _num_nodes; }
 
+  // Bound on the rounding error of the last distance (integer precision)
+  double errorBound() const { return _error_bound; }
+
+  // Pivot statistics of the last solve (compile with -DKWD_PROFILE)
+  const SimplexStats &stats() const { return _stats; }
+
+  // Column pool statistics of the last column generation solve
+  const ColumnPoolStats &poolStats() const { return _pool_stats; }
+
+  // Token to cancel the solves from another thread (nullptr to disable):
+  // it must outlive the solves that use it
+  void setCancelToken(const CancelToken *token) { cancel_token = token; }
+
   // Compute KWD distance between A and B with bipartite graph
   double dense(const Histogram2D &A, const Histogram2D &B) {
     // Compute xmin, xmax, ymin, ymax for each axis
@@ -705,14 +1035,16 @@ public:
     typedef double CostType;
 
     // Build the graph for min cost flow
-    NetSimplex<FlowType, CostType> simplex(
+    auto &simplex = pooledSimplex<FlowType, CostType>(
         'F', static_cast<int>(A.size() + B.size()),
         static_cast<int>(A.size() * B.size()));
 
     // Set the parameters
     simplex.setTimelimit(timelimit);
+    simplex.setCancelToken(cancel_token);
     simplex.setVerbosity(verbosity);
     simplex.setOptTolerance(opt_tolerance);
+    simplex.setThreads(threads);
 
     // add first d source nodes
     {
@@ -746,16 +1078,19 @@ public:
       PRINT("INFO: running NetSimplex with V=%ld and E=%ld\n",
             simplex.num_nodes(), simplex.num_arcs());
 
-    _status = simplex.run();
+    _status = simplex.run(pivotRule());
 
     _runtime = simplex.runtime();
     _iterations = simplex.iterations();
+    _stats = simplex.stats();
     _num_arcs = simplex.num_arcs();
     _num_nodes = simplex.num_nodes();
 
     double distance = std::numeric_limits<CostType>::max();
     if (_status != ProblemType::INFEASIBLE &&
-        _status != ProblemType::UNBOUNDED && _status != ProblemType::TIMELIMIT)
+        _status != ProblemType::UNBOUNDED &&
+        _status != ProblemType::TIMELIMIT &&
+        _status != ProblemType::CANCELLED)
       distance = simplex.totalCost();
 
     return distance;
@@ -778,6 +1113,8 @@ public:
       Rs = ch.FillHull(ps);
     }
 
+    Rs.reorder(node_order);
+
     Rs.merge(ps);
 
     size_t n = Rs.size();
@@ -805,13 +1142,15 @@ public:
     typedef double CostType;
 
     // Build the graph for min cost flow
-    NetSimplex<FlowType, CostType> simplex(
+    auto &simplex = pooledSimplex<FlowType, CostType>(
         'F', static_cast<int>(n), static_cast<int>(n * coprimes.size()));
 
     // Set the parameters
     simplex.setTimelimit(timelimit);
+    simplex.setCancelToken(cancel_token);
     simplex.setVerbosity(verbosity);
     simplex.setOptTolerance(opt_tolerance);
+    simplex.setThreads(threads);
 
     // add first d source nodes
     for (size_t i = 0; i < n; ++i) {
@@ -837,16 +1176,19 @@ public:
       PRINT("INFO: running NetSimplex with V=%ld and E=%ld\n",
             simplex.num_nodes(), simplex.num_arcs());
 
-    _status = simplex.run();
+    _status = simplex.run(pivotRule());
 
     _runtime = simplex.runtime();
     _iterations = simplex.iterations();
+    _stats = simplex.stats();
     _num_arcs = simplex.num_arcs();
     _num_nodes = simplex.num_nodes();
 
     double distance = std::numeric_limits<CostType>::max();
     if (_status != ProblemType::INFEASIBLE &&
-        _status != ProblemType::UNBOUNDED && _status != ProblemType::TIMELIMIT)
+        _status != ProblemType::UNBOUNDED &&
+        _status != ProblemType::TIMELIMIT &&
+        _status != ProblemType::CANCELLED)
       distance = simplex.totalCost();
 
     return distance;
@@ -872,6 +1214,8 @@ public:
       Rs = ch.FillHull(ps);
     }
 
+    Rs.reorder(node_order);
+
     Rs.merge(ps);
 
     size_t n = Rs.size();
@@ -884,27 +1228,22 @@ public:
       ymax = std::max(ymax, Rs.getY(i));
     }
 
-    // Binary vector for positions
-    auto ID = [&ymax](int x, int y) { return x * (ymax + 1) + y; };
-
-    std::vector<bool> M((xmax + 1) * (ymax + 1), false);
-    for (size_t i = 0; i < n; ++i)
-      M[ID(Rs.getX(i), Rs.getY(i))] = true;
-
-    std::vector<size_t> H((xmax + 1) * (ymax + 1), 0);
-    for (size_t i = 0; i < n; ++i)
-      H[ID(Rs.getX(i), Rs.getY(i))] = i;
+    // Index of the points on the grid
+    auto G = indexRaster(Rs, xmax + 1, ymax + 1);
 
     typedef double FlowType;
     typedef double CostType;
 
     // Build the graph for min cost flow
-    NetSimplex<FlowType, CostType> simplex('E', static_cast<int>(n), 0);
+    auto &simplex =
+        pooledSimplex<FlowType, CostType>('E', static_cast<int>(n), 0);
 
     // Set the parameters
     simplex.setTimelimit(timelimit);
+    simplex.setCancelToken(cancel_token);
     simplex.setVerbosity(verbosity);
     simplex.setOptTolerance(opt_tolerance);
+    simplex.setThreads(threads);
 
     // add first d source nodes
     for (size_t i = 0; i < n; ++i)
@@ -916,22 +1255,23 @@ public:
 
     vector<double> pi(n, 0);
 
-    Vars vars(n);
-    for (size_t i = 0; i < n; ++i)
-      vars[i].a = int(i);
+    Vars vars;
 
     Vars vnew;
     vnew.reserve(n);
 
     // Init the simplex
-    simplex.run();
+    simplex.initColumnPool(pool_age);
+    simplex.run(pivotRule());
     _iterations = simplex.iterations();
+    _stats = simplex.stats();
 
     // Start separation
     while (true) {
-      _status = simplex.reRun();
+      _status = simplex.reRun(pivotRule());
 
-      if (_status == ProblemType::TIMELIMIT)
+      if (_status == ProblemType::TIMELIMIT ||
+          _status == ProblemType::CANCELLED)
         break;
 
       // Take the dual values
@@ -939,62 +1279,20 @@ public:
         pi[j] = -simplex.potential(j);
 
       // Solve separation problem:
-      //#pragma omp parallel
       auto start_tt = std::chrono::steady_clock::now();
-
-      {
-        //#pragma omp for schedule(dynamic, 8)
-        for (size_t h = 0; h < n; ++h) {
-          int a = Rs.getX(h);
-          int b = Rs.getY(h);
-
-          double best_v = -FEASIBILITY_TOL;
-          double best_c = -1;
-          int best_j = 0;
-
-          for (const auto &p : coprimes) {
-            int v = p.v;
-            int w = p.w;
-            double c_ij = p.c_vw; // TODO: Memomize!
-            if (a + v >= 0 && a + v <= xmax && b + w >= 0 && b + w <= ymax &&
-                M[ID(a + v, b + w)]) {
-              size_t j = H[ID(a + v, b + w)];
-
-              double violation = c_ij - pi[h] + pi[j];
-              if (violation < best_v) {
-                best_v = violation;
-                best_c = c_ij;
-                best_j = j;
-              }
-            }
-          }
-          // Store most violated cuts for element i
-          vars[h].b = best_j;
-          vars[h].c = best_c;
-        }
-      }
+      separateColumns(Rs, xmax + 1, ymax + 1, G, pi, -FEASIBILITY_TOL, vars,
+                      vnew);
       auto end_tt = std::chrono::steady_clock::now();
       _all_p += double(std::chrono::duration_cast<std::chrono::milliseconds>(
                            end_tt - start_tt)
                            .count()) /
                 1000;
 
-      // Take all negative reduced cost variables
-      vnew.clear();
-      for (auto &v : vars) {
-        if (v.c > -1)
-          vnew.push_back(v);
-        v.c = -1;
-      }
-
       if (vnew.empty())
         break;
 
-      std::sort(vnew.begin(), vnew.end(),
-                [](const Var &v, const Var &w) { return v.c > w.c; });
-
       // Replace old constraints with new ones
-      int new_arcs = simplex.updateArcs(vnew);
+      int new_arcs = simplex.addColumns(vnew);
 
       n_cuts += new_arcs;
 
@@ -1003,6 +1301,8 @@ public:
 
     _runtime = simplex.runtime();
     _iterations = simplex.iterations();
+    _stats = simplex.stats();
+    _pool_stats = simplex.poolStats();
     _num_arcs = simplex.num_arcs();
     _num_nodes = simplex.num_nodes();
 
@@ -1021,14 +1321,7 @@ public:
     return fobj;
   }
 
-  void init_coprimes(int L) {
-    coprimes.clear();
-    for (int v = -L; v <= L; ++v)
-      for (int w = -L; w <= L; ++w)
-        if (!(v == 0 && w == 0) && GCD(v, w) == 1)
-          coprimes.emplace_back(v, w, sqrt(double(v * v + w * w)));
-    coprimes.shrink_to_fit();
-  }
+  void init_coprimes(int L) { coprimes = CoprimeTable::get(L); }
 
   // In case of coordinates with regulare distance, recode the coordinate to
   // conescutive integers
@@ -1147,8 +1440,8 @@ public:
 
     int xmin = xy[0];
     int ymin = xy[1];
-    // int xmax = xy[2];
-    // int ymax = xy[3];
+    int xmax = xy[2];
+    int ymax = xy[3];
 
     // Rescale all integers coordinates to (0,0)
     double tot_w1 = 0.0;
@@ -1168,12 +1461,14 @@ public:
 
     if (algorithm == KWD_VAL_BIPARTITE) {
       // Network Simplex: Build the bipartite graph
-      NetSimplex<double, double> simplex('F', (n + n), (n * n));
+      auto &simplex = pooledSimplex<double, double>('F', (n + n), (n * n));
 
       // Set the parameters
       simplex.setTimelimit(timelimit);
+      simplex.setCancelToken(cancel_token);
       simplex.setVerbosity(verbosity);
       simplex.setOptTolerance(opt_tolerance);
+      simplex.setThreads(threads);
 
       for (int i = 0; i < n; ++i)
         simplex.addNode(i, W1[i]);
@@ -1197,23 +1492,74 @@ public:
               simplex.num_nodes(), simplex.num_arcs());
 
       // Solve the problem to compute the distance
-      _status = simplex.run();
+      _status = simplex.run(pivotRule());
 
       _runtime = simplex.runtime();
       _iterations = simplex.iterations();
+      _stats = simplex.stats();
       _num_arcs = simplex.num_arcs();
       _num_nodes = simplex.num_nodes();
 
       double distance = std::numeric_limits<double>::max();
       if (_status != ProblemType::INFEASIBLE &&
           _status != ProblemType::UNBOUNDED &&
-          _status != ProblemType::TIMELIMIT)
+          _status != ProblemType::TIMELIMIT &&
+          _status != ProblemType::CANCELLED)
 
         distance = simplex.totalCost();
 
       return distance;
     }
 
+    if (algorithm == KWD_VAL_AUCTION) {
+      // Masses in integer units, sources first and then sinks
+      std::vector<double> B(n + n);
+      for (int i = 0; i < n; ++i) {
+        B[i] = W1[i];
+        B[n + i] = -W2[i];
+      }
+      double mass_scale = 1.0;
+      std::vector<int64_t> Q = scaleSupplies<int64_t>(B, mass_scale);
+
+      Auction<> auction(n, &Xs[0], &Ys[0]);
+      auction.setTimelimit(timelimit);
+      auction.setCancelToken(cancel_token);
+      auction.setVerbosity(verbosity);
+      auction.setOptTolerance(opt_tolerance);
+      auction.setThreads(threads);
+
+      for (int i = 0; i < n + n; ++i)
+        auction.addNode(i, Q[i]);
+
+      if (verbosity == KWD_VAL_INFO)
+        PRINT("INFO: running Auction with V=%ld and E=%ld (implicit)\n",
+              auction.num_nodes(), auction.num_arcs());
+
+      _status = auction.run();
+
+      _runtime = auction.runtime();
+      _iterations = auction.iterations();
+      _stats = SimplexStats();
+      _num_arcs = auction.num_arcs();
+      _num_nodes = auction.num_nodes();
+
+      double distance = std::numeric_limits<double>::max();
+      if (_status != ProblemType::INFEASIBLE &&
+          _status != ProblemType::UNBOUNDED &&
+          _status != ProblemType::TIMELIMIT &&
+          _status != ProblemType::CANCELLED)
+        distance = auction.totalCost() / mass_scale;
+
+      // The gap of the dual bound, plus the rounding of the masses: every
+      // mass is off by less than one unit, moved at most along the diagonal
+      double D = std::sqrt(double(xmax - xmin) * double(xmax - xmin) +
+                           double(ymax - ymin) * double(ymax - ymin));
+      _error_bound = (auction.totalCost() - auction.lowerBound()) / mass_scale +
+                     D * double(n + n) / mass_scale;
+
+      return distance;
+    }
+
     // Second option for algorithm
     if (algorithm == KWD_VAL_MINCOSTFLOW) {
       PointCloud2D ps = mergeHistograms(n, &Xs[0], &Ys[0], &W1[0], &W2[0]);
@@ -1228,6 +1574,8 @@ public:
         Rs = ch.FillHull(ps);
       }
 
+      Rs.reorder(node_order);
+
       Rs.merge(ps);
 
       int n = static_cast<int>(Rs.size());
@@ -1246,8 +1594,7 @@ public:
       xmax++;
       ymax++;
 
-      init_coprimes(
-          std::max(xmax - xmin, ymax - ymin)); // TODO: make it parallel
+      init_coprimes(std::max(xmax - xmin, ymax - ymin));
 
       // Binary vector for positions
       auto ID = [&ymax](int x, int y) { return x * ymax + y; };
@@ -1264,13 +1611,15 @@ public:
       typedef double CostType;
 
       // Build the graph for min cost flow
-      NetSimplex<FlowType, CostType> simplex(
+      auto &simplex = pooledSimplex<FlowType, CostType>(
           'F', n, n * static_cast<int>(coprimes.size()));
 
       // Set the parameters
       simplex.setTimelimit(timelimit);
+      simplex.setCancelToken(cancel_token);
       simplex.setVerbosity(verbosity);
       simplex.setOptTolerance(opt_tolerance);
+      simplex.setThreads(threads);
 
       // add first d source nodes
       for (int i = 0; i < n; ++i)
@@ -1295,10 +1644,11 @@ public:
         PRINT("INFO: running NetSimplex with V=%ld and E=%ld\n",
               simplex.num_nodes(), simplex.num_arcs());
 
-      _status = simplex.run();
+      _status = simplex.run(pivotRule());
 
       _runtime = simplex.runtime();
       _iterations = simplex.iterations();
+      _stats = simplex.stats();
       _num_arcs = simplex.num_arcs();
       _num_nodes = simplex.num_nodes();
 
@@ -1306,7 +1656,8 @@ public:
 
       if (_status != ProblemType::INFEASIBLE &&
           _status != ProblemType::UNBOUNDED &&
-          _status != ProblemType::TIMELIMIT)
+          _status != ProblemType::TIMELIMIT &&
+          _status != ProblemType::CANCELLED)
         distance = simplex.totalCost();
 
       return distance;
@@ -1329,6 +1680,8 @@ public:
         Rs = ch.FillHull(ps);
       }
 
+      Rs.reorder(node_order);
+
       Rs.merge(ps);
 
       int n = Rs.size();
@@ -1344,29 +1697,23 @@ public:
       xmax++;
       ymax++;
 
-      init_coprimes(std::max(xmax, ymax) - 1); // TODO: make it parallel
-
-      // Binary vector for positions
-      auto ID = [&ymax](int x, int y) { return x * ymax + y; };
-
-      std::vector<bool> M(size_t(xmax) * size_t(ymax), false);
-      for (int i = 0; i < n; ++i)
-        M[ID(Rs.getX(i), Rs.getY(i))] = true;
+      init_coprimes(std::max(xmax, ymax) - 1);
 
-      std::vector<int> H(size_t(xmax) * size_t(ymax), 0);
-      for (int i = 0; i < n; ++i)
-        H[ID(Rs.getX(i), Rs.getY(i))] = i;
+      // Index of the points on the grid
+      auto G = indexRaster(Rs, xmax, ymax);
 
       typedef double FlowType;
       typedef double CostType;
 
       // Build the graph for min cost flow
-      NetSimplex<FlowType, CostType> simplex('E', n, 0);
+      auto &simplex = pooledSimplex<FlowType, CostType>('E', n, 0);
 
       // Set the parameters
       simplex.setTimelimit(timelimit);
+      simplex.setCancelToken(cancel_token);
       simplex.setVerbosity(verbosity);
       simplex.setOptTolerance(opt_tolerance);
+      simplex.setThreads(threads);
 
       // add first d source nodes
       for (int i = 0; i < n; ++i)
@@ -1379,20 +1726,20 @@ public:
 
       vector<double> pi(n, 0);
 
-      Vars vars(n);
-      for (int i = 0; i < n; ++i)
-        vars[i].a = i;
+      Vars vars;
 
       Vars vnew;
       vnew.reserve(n);
 
       // Init the simplex
-      simplex.run();
+      simplex.initColumnPool(pool_age);
+      simplex.run(pivotRule());
 
       // Start separation
       while (true) {
-        _status = simplex.reRun();
-        if (_status == ProblemType::TIMELIMIT)
+        _status = simplex.reRun(pivotRule());
+        if (_status == ProblemType::TIMELIMIT ||
+            _status == ProblemType::CANCELLED)
           break;
 
         // Take the dual values
@@ -1401,51 +1748,7 @@ public:
 
         // Solve separation problem:
         auto start_tt = std::chrono::steady_clock::now();
-#ifdef _OPENMP
-#pragma omp parallel
-        {
-#pragma omp for schedule(dynamic, 1)
-#else
-        {
-#endif
-          for (int h = 0; h < n; ++h) {
-            int a = Rs.getX(h);
-            int b = Rs.getY(h);
-
-            double best_v = negeps;
-            double best_c = -1;
-            int best_j = 0;
-
-            for (const auto &p : coprimes) {
-              int v = p.v;
-              int w = p.w;
-              double c_ij = p.c_vw;
-              if (a + v >= 0 && a + v < xmax && b + w >= 0 && b + w < ymax &&
-                  M[ID(a + v, b + w)]) {
-                int j = H[ID(a + v, b + w)];
-
-                double violation = c_ij - pi[h] + pi[j];
-                if (violation < best_v) {
-                  best_v = violation;
-                  best_c = c_ij;
-                  best_j = j;
-                }
-              }
-            }
-            // Store most violated cuts for element i
-            vars[h].b = best_j;
-            vars[h].c = best_c;
-          }
-        }
-
-        // Take all negative reduced cost variables
-        vnew.clear();
-        for (auto &v : vars) {
-          if (v.c > -1)
-            vnew.push_back(v);
-          v.c = -1;
-        }
-
+        separateColumns(Rs, xmax, ymax, G, pi, negeps, vars, vnew);
         auto end_tt = std::chrono::steady_clock::now();
         _all_p += double(std::chrono::duration_cast<std::chrono::milliseconds>(
                              end_tt - start_tt)
@@ -1455,11 +1758,8 @@ public:
         if (vnew.empty())
           break;
 
-        std::sort(vnew.begin(), vnew.end(),
-                  [](const Var &v, const Var &w) { return v.c > w.c; });
-
         // Replace old constraints with new ones
-        int new_arcs = simplex.updateArcs(vnew);
+        int new_arcs = simplex.addColumns(vnew);
 
         n_cuts += new_arcs;
 
@@ -1474,6 +1774,8 @@ public:
 
       _runtime = _all;
       _iterations = simplex.iterations();
+      _stats = simplex.stats();
+      _pool_stats = simplex.poolStats();
       _num_arcs = simplex.num_arcs();
       _num_nodes = simplex.num_nodes();
 
@@ -1491,82 +1793,49 @@ public:
 
   double compareApprox(int _n, int *_Xs, int *_Ys, double *_W1, double *_W2,
                        int LL) {
-    // Check for correct input
-    if (check_coding(_n, _Xs))
-      PRINT(
-          "WARNING: the Xs input coordinates are not consecutives integers.\n");
-    if (check_coding(_n, _Ys))
-      PRINT(
-          "WARNING: the Ys input coordinates are not consecutives integers.\n");
-
-    if (recode != "") {
-      PRINT("INFO: Recoding the input coordinates to consecutive integers.\n");
-      recoding(_n, _Xs);
-      recoding(_n, _Ys);
-    }
-
-    if (verbosity == KWD_VAL_INFO)
-      dumpParam();
-    intpair2int XY = reindex(_n, _Xs, _Ys);
-    int n = XY.size();
-
     vector<int> Xs, Ys;
     vector<double> W1, W2;
-    Xs.resize(n, 0);
-    Ys.resize(n, 0);
-    W1.resize(n, 0);
-    W2.resize(n, 0);
-    for (int i = 0; i < _n; i++) {
-      int idx = XY[int_pair(_Xs[i], _Ys[i])];
-      Xs[idx] = _Xs[i];
-      Ys[idx] = _Ys[i];
-      W1[idx] += _W1[i];
-      W2[idx] += _W2[i];
-      if (_W1[i] < 0.0) {
-        PRINT("WARNING: weight W1[%d]=%.4f is negative. Only positive weights "
-              "are allowed.\n",
-              i, _W1[i]);
-        throw std::runtime_error(
-            "FATAL ERROR: Input histogram with negative weigths");
-      }
-      if (_W2[i] < 0.0) {
-        PRINT("WARNING: weight W2[%d]=%.4f is negative. Only positive weights "
-              "are allowed.\n",
-              i, _W2[i]);
-        throw std::runtime_error(
-            "FATAL ERROR: Input histogram with negative weigths");
-      }
-    }
+    double tot_w1 = 0.0;
+    double tot_w2 = 0.0;
+    prepareInput(_n, _Xs, _Ys, _W1, _W2, Xs, Ys, W1, W2, tot_w1, tot_w2);
+    int n = static_cast<int>(Xs.size());
 
-    // Get the largest bounding box
-    auto xy = getMinMax(n, &Xs[0], &Ys[0]);
+    // Multiscale method: column generation over a pyramid of the histograms
+    if (method == KWD_VAL_MULTISCALE) {
+      PointCloud2D ps = mergeHistograms(n, &Xs[0], &Ys[0], &W1[0], &W2[0]);
 
-    int xmin = xy[0];
-    int ymin = xy[1];
-    // int xmax = xy[2];
-    // int ymax = xy[3];
+      // Compute convex hull
+      ConvexHull ch;
+      PointCloud2D As, Rs;
+      if (convex_hull) {
+        As = ch.find(ps);
+        Rs = ch.FillHull(As);
+      } else {
+        Rs = ch.FillHull(ps);
+      }
 
-    // Rescale all integers coordinates to (0,0)
-    double tot_w1 = 0.0;
-    double tot_w2 = 0.0;
-    for (int i = 0; i < n; ++i) {
-      Xs[i] = Xs[i] - xmin;
-      Ys[i] = Ys[i] - ymin;
+      Rs.reorder(node_order);
 
-      tot_w1 += W1[i];
-      tot_w2 += W2[i];
-    }
+      Rs.merge(ps);
 
-    // Rebalance the total mass only if it is not an unbalanced probelm
-    if (!unbalanced) {
-      for (int i = 0; i < n; ++i) {
-        W1[i] = W1[i] / tot_w1;
-        W2[i] = W2[i] / tot_w2;
+      if (LL != L) {
+        L = LL;
+        init_coprimes(LL);
       }
+
+      double fobj = solveMultiscale(Rs);
+      if (unbalanced && fobj < std::numeric_limits<double>::max())
+        fobj = fobj / std::max(tot_w1, tot_w2);
+
+      if (_n_log > 0)
+        PRINT("it: %ld, fobj: %f, all: %f\n", (long)_iterations, fobj,
+              _runtime);
+
+      return fobj;
     }
 
     // Second option for algorithm
-    if (algorithm == KWD_VAL_FULLMODEL) {
+    if (algorithm == KWD_VAL_FULLMODEL || algorithm == KWD_VAL_COSTSCALING) {
       PointCloud2D ps = mergeHistograms(n, &Xs[0], &Ys[0], &W1[0], &W2[0]);
 
       // Compute convex hull
@@ -1579,8 +1848,9 @@ public:
         Rs = ch.FillHull(ps);
       }
 
+      Rs.reorder(node_order);
+
       Rs.merge(ps);
-      Rs.dump();
       int n = static_cast<int>(Rs.size());
 
       // Compute xmax, ymax for each axis
@@ -1599,87 +1869,57 @@ public:
 
       if (LL != L) {
         L = LL;
-        init_coprimes(LL); // TODO: make it parallel
+        init_coprimes(LL);
       }
 
-      // Binary vector for positions
-      auto ID = [&ymax](int x, int y) { return x * ymax + y; };
-
-      std::vector<bool> M(size_t(xmax) * size_t(ymax), false);
-      for (int i = 0; i < n; ++i)
-        M[ID(Rs.getX(i), Rs.getY(i))] = true;
-
-      std::vector<int> H(size_t(xmax) * size_t(ymax), 0);
-      for (int i = 0; i < n; ++i)
-        H[ID(Rs.getX(i), Rs.getY(i))] = i;
+      if (algorithm == KWD_VAL_COSTSCALING)
+        return solveCostScaling(Rs, xmin, ymin, xmax, ymax, tot_w1, tot_w2);
 
       typedef double FlowType;
       typedef double CostType;
 
-      // Build the graph for min cost flow
-      NetSimplex<FlowType, CostType> simplex(
-          'F', n + int(unbalanced == true),
-          n *static_cast<int>(coprimes.size()));
+      // Graph with implicit arcs, without the unbalanced node
+      if (implicit_arcs && !unbalanced) {
+        checkImplicitArcs();
+        NetSimplexGrid<FlowType, CostType> simplex(
+            gridNetwork<CostType>(Rs, xmax, ymax));
+        setupGridSolver(simplex);
 
-      // Set the parameters
-      simplex.setTimelimit(timelimit);
-      simplex.setVerbosity(verbosity);
-      simplex.setOptTolerance(opt_tolerance);
+        for (int i = 0; i < n; ++i)
+          simplex.addNode(i, Rs.getB(i));
 
-      // add first d source nodes
-      for (int i = 0; i < n; ++i)
-        simplex.addNode(i, Rs.getB(i));
+        _status = simplex.run();
+        _error_bound = 0.0;
 
-      for (int h = 0; h < n; ++h) {
-        int i = Rs.getX(h);
-        int j = Rs.getY(h);
-        for (const auto &p : coprimes) {
-          int v = p.v;
-          int w = p.w;
-          if (i + v >= xmin && i + v < xmax && j + w >= ymin && j + w < ymax &&
-              M[ID(i + v, j + w)]) {
-            int ff = H[ID(i + v, j + w)];
-            simplex.addArc(h, ff, p.c_vw);
-          }
-        }
-      }
+        _runtime = simplex.runtime();
+        _iterations = simplex.iterations();
+        _stats = simplex.stats();
+        _num_arcs = simplex.num_arcs();
+        _num_nodes = simplex.num_nodes();
 
-      // Add noded for unbalanced transport, if parater is set
-      if (unbalanced) {
-        double bb = -Rs.balance();
-        double c1 = (bb < 0 ? unbal_cost : 0);
-        double c2 = (bb < 0 ? 0 : unbal_cost);
-        simplex.addNode(n, bb);
-
-        for (int i = 0; i < n; ++i)
-          simplex.addArc(i, n, c1);
-
-        for (int i = 0; i < n; ++i)
-          simplex.addArc(n, i, c2);
-      }
-
-      // Solve the problem to compute the distance
-      if (verbosity == KWD_VAL_INFO)
-        PRINT("INFO: running NetSimplex with V=%ld and E=%ld\n",
-              simplex.num_nodes(), simplex.num_arcs());
-      _status = simplex.run();
-
-      _runtime = simplex.runtime();
-      _iterations = simplex.iterations();
-      _num_arcs = simplex.num_arcs();
-      _num_nodes = simplex.num_nodes();
+        if (verbosity == KWD_VAL_INFO)
+          PRINT("INFO: NetSimplexGrid with V=%ld and E=%ld (implicit)\n",
+                simplex.num_nodes(), _num_arcs);
 
-      double distance = std::numeric_limits<CostType>::max();
+        double distance = std::numeric_limits<CostType>::max();
 
-      if (_status != ProblemType::INFEASIBLE &&
-          _status != ProblemType::UNBOUNDED &&
-          _status != ProblemType::TIMELIMIT)
-        distance = simplex.totalCost();
+        if (_status != ProblemType::INFEASIBLE &&
+            _status != ProblemType::UNBOUNDED &&
+            _status != ProblemType::TIMELIMIT &&
+            _status != ProblemType::CANCELLED)
+          distance = simplex.totalCost();
 
-      if (unbalanced)
-        distance = distance / std::max(tot_w1, tot_w2);
+        return distance;
+      }
 
-      return distance;
+      if (precision == KWD_VAL_SINGLE)
+        return solveFullModel<float, float>(Rs, xmin, ymin, xmax, ymax, tot_w1,
+                                            tot_w2);
+      if (precision == KWD_VAL_INTEGER)
+        return solveFullModel<int64_t, int64_t>(Rs, xmin, ymin, xmax, ymax,
+                                                tot_w1, tot_w2);
+      return solveFullModel<FlowType, CostType>(Rs, xmin, ymin, xmax, ymax,
+                                                tot_w1, tot_w2);
     }
 
     // Second option for algorithm
@@ -1699,6 +1939,8 @@ public:
         Rs = ch.FillHull(ps);
       }
 
+      Rs.reorder(node_order);
+
       Rs.merge(ps);
 
       int n = Rs.size();
@@ -1716,31 +1958,25 @@ public:
 
       if (LL != L) {
         L = LL;
-        init_coprimes(LL); // TODO: make it parallel
+        init_coprimes(LL);
       }
 
-      // Binary vector for positions
-      auto ID = [&ymax](int x, int y) { return x * ymax + y; };
-
-      std::vector<bool> M(size_t(xmax) * size_t(ymax), false);
-      for (int i = 0; i < n; ++i)
-        M[ID(Rs.getX(i), Rs.getY(i))] = true;
-
-      std::vector<int> H(size_t(xmax) * size_t(ymax), 0);
-      for (int i = 0; i < n; ++i)
-        H[ID(Rs.getX(i), Rs.getY(i))] = i;
+      // Index of the points on the grid
+      auto G = indexRaster(Rs, xmax, ymax);
 
       typedef double FlowType;
       typedef double CostType;
 
       // Build the graph for min cost flow
-      NetSimplex<FlowType, CostType> simplex('E', n + int(unbalanced == true),
-                                             0);
+      auto &simplex = pooledSimplex<FlowType, CostType>(
+          'E', n + int(unbalanced == true), 0);
 
       // Set the parameters
       simplex.setTimelimit(timelimit);
+      simplex.setCancelToken(cancel_token);
       simplex.setVerbosity(verbosity);
       simplex.setOptTolerance(opt_tolerance);
+      simplex.setThreads(threads);
 
       // add first d source nodes
       for (int i = 0; i < n; ++i)
@@ -1767,20 +2003,20 @@ public:
 
       vector<double> pi(n, 0);
 
-      Vars vars(n);
-      for (int i = 0; i < n; ++i)
-        vars[i].a = i;
+      Vars vars;
 
       Vars vnew;
       vnew.reserve(n);
 
       // Init the simplex
-      simplex.run();
+      simplex.initColumnPool(pool_age);
+      simplex.run(pivotRule());
 
       // Start separation
       while (true) {
-        _status = simplex.reRun();
-        if (_status == ProblemType::TIMELIMIT)
+        _status = simplex.reRun(pivotRule());
+        if (_status == ProblemType::TIMELIMIT ||
+            _status == ProblemType::CANCELLED)
           break;
 
         // Take the dual values
@@ -1789,51 +2025,7 @@ public:
 
         // Solve separation problem:
         auto start_tt = std::chrono::steady_clock::now();
-#ifdef _OPENMP
-#pragma omp parallel
-        {
-#pragma omp for schedule(dynamic, 1)
-#else
-        {
-#endif
-          for (int h = 0; h < n; ++h) {
-            int a = Rs.getX(h);
-            int b = Rs.getY(h);
-
-            double best_v = negeps;
-            double best_c = -1;
-            int best_j = 0;
-
-            for (const auto &p : coprimes) {
-              int v = p.v;
-              int w = p.w;
-              double c_ij = p.c_vw;
-              if (a + v >= 0 && a + v < xmax && b + w >= 0 && b + w < ymax &&
-                  M[ID(a + v, b + w)]) {
-                int j = H[ID(a + v, b + w)];
-
-                double violation = c_ij - pi[h] + pi[j];
-                if (violation < best_v) {
-                  best_v = violation;
-                  best_c = c_ij;
-                  best_j = j;
-                }
-              }
-            }
-            // Store most violated cuts for element i
-            vars[h].b = best_j;
-            vars[h].c = best_c;
-          }
-        }
-
-        // Take all negative reduced cost variables
-        vnew.clear();
-        for (auto &v : vars) {
-          if (v.c > -1)
-            vnew.push_back(v);
-          v.c = -1;
-        }
-
+        separateColumns(Rs, xmax, ymax, G, pi, negeps, vars, vnew);
         auto end_tt = std::chrono::steady_clock::now();
         _all_p += double(std::chrono::duration_cast<std::chrono::milliseconds>(
                              end_tt - start_tt)
@@ -1843,11 +2035,8 @@ public:
         if (vnew.empty())
           break;
 
-        std::sort(vnew.begin(), vnew.end(),
-                  [](const Var &v, const Var &w) { return v.c > w.c; });
-
         // Replace old constraints with new ones
-        int new_arcs = simplex.updateArcs(vnew);
+        int new_arcs = simplex.addColumns(vnew);
 
         n_cuts += new_arcs;
 
@@ -1862,6 +2051,8 @@ public:
 
       _runtime = _all;
       _iterations = simplex.iterations();
+      _stats = simplex.stats();
+      _pool_stats = simplex.poolStats();
       _num_arcs = simplex.num_arcs();
       _num_nodes = simplex.num_nodes();
 
@@ -1879,6 +2070,142 @@ public:
     return -1;
   }
 
+  // Approximate distances for L = 1, ..., LL on the same network: every
+  // step adds only the arcs of the new coprime directions, with
+  // max(|v|, |w|) = L, and the network simplex continues from the basis of
+  // the previous step. If stop_tol is positive, the steps stop early once
+  // the relative change of the distance is at most stop_tol. Return the
+  // distance of every solved step
+  vector<double> compareApproxIncremental(int _n, int *_Xs, int *_Ys,
+                                          double *_W1, double *_W2, int LL,
+                                          double stop_tol = 0.0) {
+    vector<int> Xs, Ys;
+    vector<double> W1, W2;
+    double tot_w1 = 0.0;
+    double tot_w2 = 0.0;
+    prepareInput(_n, _Xs, _Ys, _W1, _W2, Xs, Ys, W1, W2, tot_w1, tot_w2);
+    int n = static_cast<int>(Xs.size());
+
+    PointCloud2D ps = mergeHistograms(n, &Xs[0], &Ys[0], &W1[0], &W2[0]);
+
+    // Compute convex hull
+    ConvexHull ch;
+    PointCloud2D As, Rs;
+    if (convex_hull) {
+      As = ch.find(ps);
+      Rs = ch.FillHull(As);
+    } else {
+      Rs = ch.FillHull(ps);
+    }
+
+    Rs.reorder(node_order);
+
+    Rs.merge(ps);
+
+    n = int(Rs.size());
+
+    int xmax = 0;
+    int ymax = 0;
+    for (int i = 0; i < n; ++i) {
+      xmax = std::max(xmax, Rs.getX(i) + 1);
+      ymax = std::max(ymax, Rs.getY(i) + 1);
+    }
+
+    if (LL != L) {
+      L = LL;
+      init_coprimes(LL);
+    }
+
+    // Binary vector for positions
+    auto ID = [&ymax](int x, int y) { return x * ymax + y; };
+
+    std::vector<bool> M(size_t(xmax) * size_t(ymax), false);
+    std::vector<int> H(size_t(xmax) * size_t(ymax), 0);
+    for (int i = 0; i < n; ++i) {
+      M[ID(Rs.getX(i), Rs.getY(i))] = true;
+      H[ID(Rs.getX(i), Rs.getY(i))] = i;
+    }
+
+    typedef double FlowType;
+    typedef double CostType;
+
+    auto &simplex = pooledSimplex<FlowType, CostType>(
+        'E', n + int(unbalanced == true), 0);
+
+    simplex.setTimelimit(timelimit);
+    simplex.setCancelToken(cancel_token);
+    simplex.setVerbosity(verbosity);
+    simplex.setOptTolerance(opt_tolerance);
+    simplex.setThreads(threads);
+
+    for (int i = 0; i < n; ++i)
+      simplex.addNode(i, Rs.getB(i));
+
+    // Add noded for unbalanced transport, if parater is set
+    if (unbalanced) {
+      double bb = -Rs.balance();
+      double c1 = (bb < 0 ? unbal_cost : 0);
+      double c2 = (bb < 0 ? 0 : unbal_cost);
+      simplex.addNode(n, bb);
+
+      for (int i = 0; i < n; ++i)
+        simplex.addArc(i, n, c1);
+
+      for (int i = 0; i < n; ++i)
+        simplex.addArc(n, i, c2);
+    }
+
+    vector<double> Ds;
+    Ds.reserve(LL);
+    for (int l = 1; l <= LL; ++l) {
+      // Arcs of the new directions
+      for (int h = 0; h < n; ++h) {
+        int a = Rs.getX(h);
+        int b = Rs.getY(h);
+        for (const auto &p : coprimes) {
+          int v = p.v;
+          int w = p.w;
+          if (std::max(std::abs(v), std::abs(w)) != l)
+            continue;
+          if (a + v >= 0 && a + v < xmax && b + w >= 0 && b + w < ymax &&
+              M[ID(a + v, b + w)])
+            simplex.addArc(h, H[ID(a + v, b + w)], p.c_vw);
+        }
+      }
+
+      if (l == 1)
+        _status = simplex.run(pivotRule());
+      else
+        _status = simplex.reRun(pivotRule());
+
+      // Runtime, pivots and statistics add up over the steps
+      _runtime = simplex.runtime();
+      _iterations = simplex.iterations();
+      _stats = simplex.stats();
+
+      if (_status != ProblemType::OPTIMAL)
+        break;
+
+      double fobj = simplex.totalCost();
+      if (unbalanced)
+        fobj = fobj / std::max(tot_w1, tot_w2);
+
+      if (verbosity == KWD_VAL_INFO)
+        PRINT("INFO: L=%d, distance: %.6f, E=%ld, runtime: %.3f\n", l, fobj,
+              simplex.num_arcs(), _runtime);
+
+      Ds.push_back(fobj);
+      if (stop_tol > 0 && l > 1 &&
+          std::abs(Ds[l - 2] - fobj) <= stop_tol * std::abs(fobj))
+        break;
+    }
+
+    _num_arcs = simplex.num_arcs();
+    _num_nodes = simplex.num_nodes();
+
+    return Ds;
+  }
+
   vector<double> compareApprox(int _n, int _m, int *_Xs, int *_Ys, double *_W1,
                                double *_Ws, int LL) {
     // Check for correct input
@@ -1965,7 +2292,7 @@ public:
     // Set the coprimes set
     if (LL != L) {
       L = LL;
-      init_coprimes(LL); // TODO: make it parallel
+      init_coprimes(LL);
     }
 
     // Return value
@@ -1984,10 +2311,13 @@ public:
       Rs = ch.FillHull(ps);
     }
 
+    Rs.reorder(node_order);
+
     int n = static_cast<int>(Rs.size());
 
     // Second option for algorithm
-    if (algorithm == KWD_VAL_MINCOSTFLOW) {
+    if (algorithm == KWD_VAL_MINCOSTFLOW ||
+        algorithm == KWD_VAL_COSTSCALING) {
       // Compute xmax, ymax for each axis
       int xmin = std::numeric_limits<int>::max();
       int ymin = std::numeric_limits<int>::max();
@@ -2002,123 +2332,127 @@ public:
       xmax++;
       ymax++;
 
-      // Binary vector for positions
-      auto ID = [&ymax](int x, int y) { return x * ymax + y; };
-
-      std::vector<bool> M(size_t(xmax) * size_t(ymax), false);
-      for (int i = 0; i < n; ++i)
-        M[ID(Rs.getX(i), Rs.getY(i))] = true;
-
-      std::vector<int> H(size_t(xmax) * size_t(ymax), 0);
-      for (int i = 0; i < n; ++i)
-        H[ID(Rs.getX(i), Rs.getY(i))] = i;
-
-      // Serve questo passaggio?
-      // Rs.merge(ps); // CHECK: Posso mettere i pesi direttamente sul modello
-
-      typedef double FlowType;
-      typedef double CostType;
-      // Build the graph for min cost flow
-      NetSimplex<FlowType, CostType> simplex(
-          'F', n + int(unbalanced == true),
-          n *static_cast<int>(coprimes.size()));
-
-      // Set the parameters
-      simplex.setTimelimit(timelimit);
-      simplex.setVerbosity(verbosity);
-      simplex.setOptTolerance(opt_tolerance);
-
-      // Initial set of arcs
-      for (int h = 0; h < n; ++h) {
-        int i = Rs.getX(h);
-        int j = Rs.getY(h);
-        for (const auto &p : coprimes) {
-          int v = p.v;
-          int w = p.w;
-          if (i + v >= xmin && i + v < xmax && j + w >= ymin && j + w < ymax &&
-              M[ID(i + v, j + w)]) {
-            int ff = H[ID(i + v, j + w)];
-            simplex.addArc(h, ff, p.c_vw);
+      if (algorithm == KWD_VAL_COSTSCALING) {
+        std::vector<double> Es(_m);
+        solveCostScaling(
+            Rs, xmin, ymin, xmax, ymax, _m,
+            [&](int jj, std::vector<double> &B) {
+              for (const auto &p : Rs.getM()) {
+                auto q = MXY.find(p.first);
+                if (q != MXY.end())
+                  B[p.second] = W1[q->second] - Ws[jj * N + q->second];
+                else
+                  B[p.second] = 0.0;
+              }
+              if (unbalanced)
+                B[n] = -tot_w1 + tot_ws[jj];
+            },
+            Ds, Es);
+
+        _error_bound = 0.0;
+        for (int jj = 0; jj < _m; ++jj) {
+          if (unbalanced && Ds[jj] != std::numeric_limits<double>::max()) {
+            Ds[jj] = Ds[jj] / std::max(tot_w1, tot_ws[jj]);
+            Es[jj] = Es[jj] / std::max(tot_w1, tot_ws[jj]);
           }
+          _error_bound = std::max(_error_bound, Es[jj]);
         }
+        return Ds;
       }
 
-      // Add noded for unbalanced transport, if parater is set
-      vector<size_t> lhs_arcs(n, 0);
-      vector<size_t> rhs_arcs(n, 0);
-      if (unbalanced) {
-        for (int i = 0; i < n; ++i)
-          lhs_arcs[i] = simplex.addArc(i, n, 0);
-
-        for (int i = 0; i < n; ++i)
-          rhs_arcs[i] = simplex.addArc(n, i, 0);
-      }
-
-      // Model attributes
-      _num_arcs = simplex.num_arcs();
-
-      if (verbosity == KWD_VAL_INFO)
-        PRINT("INFO: running NetSimplex with V=%ld and E=%ld\n",
-              simplex.num_nodes(), simplex.num_arcs());
+      // Graph with implicit arcs, without the unbalanced node: the basis
+      // is not reused between targets, and the threads share the network
+      if (implicit_arcs && !unbalanced) {
+        typedef double CostType;
+        auto net = gridNetwork<CostType>(Rs, xmax, ymax);
 
-      for (int jj = 0; jj < _m; ++jj) {
+        checkImplicitArcs();
+        _status = ProblemType::OPTIMAL;
+        _error_bound = 0.0;
+        _num_arcs = net->num_arcs();
+        _num_nodes = n;
 
-        //_runtime = 0.0;
-        //_iterations = 0.0;
+        if (verbosity == KWD_VAL_INFO)
+          PRINT("INFO: NetSimplexGrid with V=%d and E=%ld (implicit)\n", n,
+                _num_arcs);
 
-        // TODO: Devo ciclare sulla mappa iniziale (x,y)->idx
-        // e usare quel bilancio ai nodi, se "i"  presente nella mappa
-        // devo iterare su cosa?
-        for (const auto &p : Rs.getM()) {
-          auto q = MXY.find(p.first);
-          if (q != MXY.end()) {
-            simplex.addNode(p.second, W1[q->second] - Ws[jj * N + q->second]);
-          } else
-            simplex.addNode(p.second, 0.0);
-        }
+        int workers = batchThreads(_m);
+        std::vector<ProblemType> sts(_m, ProblemType::OPTIMAL);
 
-        if (unbalanced) {
-          double bb = -tot_w1 + tot_ws[jj];
-          simplex.addNode(n, bb); // Set the node value, it is not a true add
+#ifdef _OPENMP
+#pragma omp parallel num_threads(workers)
+#endif
+        {
+          NetSimplexGrid<double, CostType> simplex(net);
+          setupBatchSolver(simplex, workers);
 
-          double c1 = (bb < 0 ? unbal_cost : 0);
-          double c2 = (bb < 0 ? 0 : unbal_cost);
+          double runtime = 0.0;
+          uint64_t iterations = 0;
+          SimplexStats stats;
+          ProblemType status = ProblemType::OPTIMAL;
 
-          for (int i = 0; i < n; ++i)
-            simplex.setArcCost(i, c1);
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 1)
+#endif
+          for (int jj = 0; jj < _m; ++jj) {
+            for (const auto &p : Rs.getM()) {
+              auto q = MXY.find(p.first);
+              if (q != MXY.end())
+                simplex.addNode(p.second,
+                                W1[q->second] - Ws[jj * N + q->second]);
+              else
+                simplex.addNode(p.second, 0.0);
+            }
 
-          for (int i = 0; i < n; ++i)
-            simplex.setArcCost(i, c2);
-        }
+            ProblemType st = simplex.run();
 
-        _num_nodes = simplex.num_nodes();
+            runtime += simplex.runtime();
+            iterations += simplex.iterations();
+            stats += simplex.stats();
 
-        // Solve the problem to compute the distance
-        _status = simplex.run();
+            Ds[jj] = std::numeric_limits<CostType>::max();
+            sts[jj] = st;
 
-        _runtime += simplex.runtime();
-        _iterations += simplex.iterations();
+            if (st != ProblemType::INFEASIBLE &&
+                st != ProblemType::UNBOUNDED &&
+                st != ProblemType::TIMELIMIT && st != ProblemType::CANCELLED)
+              Ds[jj] = simplex.totalCost();
+            else
+              status = st;
+          }
 
-        Ds[jj] = std::numeric_limits<CostType>::max();
+#ifdef _OPENMP
+#pragma omp critical(kwd_batch_stats)
+#endif
+          {
+            _runtime += runtime;
+            _iterations += iterations;
+            _stats += stats;
+            if (status != ProblemType::OPTIMAL)
+              _status = status;
+          }
+        }
+        logBatchErrors(sts);
 
-        if (_status != ProblemType::INFEASIBLE &&
-            _status != ProblemType::UNBOUNDED &&
-            _status != ProblemType::TIMELIMIT) {
-          Ds[jj] = simplex.totalCost();
-          if (unbalanced)
-            Ds[jj] = Ds[jj] / std::max(tot_w1, tot_ws[jj]);
-        } else
-          PRINT("ERROR 1001: Network Simplex wrong. Error code: %d\n",
-                (int)_status);
+        return Ds;
       }
 
+      if (precision == KWD_VAL_SINGLE)
+        solveMinCostFlow<float, float>(Rs, xmin, ymin, xmax, ymax, MXY, W1, Ws,
+                                       N, _m, tot_w1, tot_ws, Ds);
+      else if (precision == KWD_VAL_INTEGER)
+        solveMinCostFlow<int64_t, int64_t>(Rs, xmin, ymin, xmax, ymax, MXY, W1,
+                                           Ws, N, _m, tot_w1, tot_ws, Ds);
+      else
+        solveMinCostFlow<double, double>(Rs, xmin, ymin, xmax, ymax, MXY, W1,
+                                         Ws, N, _m, tot_w1, tot_ws, Ds);
+
       return Ds;
     }
 
     // Second option for algorithm
     if (algorithm == KWD_VAL_COLGEN) {
       auto start_t = std::chrono::steady_clock::now();
-      double _all_p = 0.0;
 
       // Compute xmax, ymax for each axis
       int xmax = std::numeric_limits<int>::min();
@@ -2133,186 +2467,152 @@ public:
 
       if (LL != L) {
         L = LL;
-        init_coprimes(LL); // TODO: make it parallel
+        init_coprimes(LL);
       }
 
-      // Binary vector for positions
-      auto ID = [&ymax](int x, int y) { return x * ymax + y; };
-
-      std::vector<bool> M(size_t(xmax) * size_t(ymax), false);
-      for (int i = 0; i < n; ++i)
-        M[ID(Rs.getX(i), Rs.getY(i))] = true;
-
-      std::vector<int> H(size_t(xmax) * size_t(ymax), 0);
-      for (int i = 0; i < n; ++i)
-        H[ID(Rs.getX(i), Rs.getY(i))] = i;
+      // Index of the points on the grid
+      auto G = indexRaster(Rs, xmax, ymax);
 
       typedef double FlowType;
       typedef double CostType;
 
-      // Build the graph for min cost flow
-      NetSimplex<FlowType, CostType> simplex('E', n + int(unbalanced == true),
-                                             0);
-      // Add noded for unbalanced transport, if parater is set
-      vector<size_t> lhs_arcs(n, 0);
-      vector<size_t> rhs_arcs(n, 0);
-      if (unbalanced) {
-        for (int i = 0; i < n; ++i)
-          lhs_arcs[i] = simplex.addArc(i, n, 0);
-
-        for (int i = 0; i < n; ++i)
-          rhs_arcs[i] = simplex.addArc(n, i, 0);
-      }
+      if (verbosity == KWD_VAL_INFO)
+        PRINT("INFO: running NetSimplex with V=%d and E=%d\n",
+              n + int(unbalanced == true), unbalanced ? 2 * n : 0);
 
-      // Set the parameters
-      simplex.setTimelimit(timelimit);
-      simplex.setVerbosity(verbosity);
-      simplex.setOptTolerance(opt_tolerance);
+      _status = ProblemType::OPTIMAL;
+      _pool_stats = ColumnPoolStats();
+      _num_nodes = n + int(unbalanced == true);
 
-      if (verbosity == KWD_VAL_INFO)
-        PRINT("INFO: running NetSimplex with V=%ld and E=%ld\n",
-              simplex.num_nodes(), simplex.num_arcs());
-
-      for (int jj = 0; jj < _m; ++jj) {
-        // TODO: Devo ciclare sulla mappa iniziale (x,y)->idx
-        // e usare quel bilancio ai nodi, se "i"  presente nella mappa
-        // devo iterare su cosa?
-        for (const auto &p : Rs.getM()) {
-          auto q = MXY.find(p.first);
-          if (q != MXY.end()) {
-            simplex.addNode(p.second, W1[q->second] - Ws[jj * N + q->second]);
-          } else
-            simplex.addNode(p.second, 0.0);
-        }
+      // Rounds of every target, logged after the parallel region
+      int workers = batchThreads(_m);
+      std::vector<int> its(_m, 0);
 
+      // The targets are split among the threads: every thread has its own
+      // network simplex, while Rs, G and the coprimes are shared
+#ifdef _OPENMP
+#pragma omp parallel num_threads(workers)
+#endif
+      {
+        // Build the graph for min cost flow
+        auto &simplex = pooledSimplex<FlowType, CostType>(
+            'E', n + int(unbalanced == true), 0);
+        // Add noded for unbalanced transport, if parater is set
+        vector<size_t> lhs_arcs(n, 0);
+        vector<size_t> rhs_arcs(n, 0);
         if (unbalanced) {
-          double bb = -tot_w1 + tot_ws[jj];
-          simplex.addNode(n, bb); // Set the node value, it is not a true add
-
-          double c1 = (bb < 0 ? unbal_cost : 0);
-          double c2 = (bb < 0 ? 0 : unbal_cost);
-
           for (int i = 0; i < n; ++i)
-            simplex.setArcCost(i, c1);
+            lhs_arcs[i] = simplex.addArc(i, n, 0);
 
           for (int i = 0; i < n; ++i)
-            simplex.setArcCost(i, c2);
+            rhs_arcs[i] = simplex.addArc(n, i, 0);
         }
 
-        _num_nodes = simplex.num_nodes();
+        // Set the parameters
+        setupBatchSolver(simplex, workers);
+
+        uint64_t iterations = 0;
+        SimplexStats stats;
+        ColumnPoolStats pool_stats;
+        ProblemType status = ProblemType::OPTIMAL;
 
-        int it = 0;
-        int n_cuts = 0;
-        // CostType fobj = 0;
         double negeps = std::nextafter(-opt_tolerance, -0.0);
 
         vector<double> pi(n, 0);
 
-        Vars vars(n);
-        for (int i = 0; i < n; ++i)
-          vars[i].a = i;
+        Vars vars;
 
         Vars vnew;
         vnew.reserve(n);
 
-        // Init the simplex
-        simplex.run();
-
-        // Start separation
-        while (true) {
-          _status = simplex.reRun();
-          if (_status == ProblemType::TIMELIMIT)
-            break;
-
-          // Take the dual values
-          for (int j = 0; j < n; ++j)
-            pi[j] = -simplex.potential(j);
-
-          // Solve separation problem:
-          auto start_tt = std::chrono::steady_clock::now();
 #ifdef _OPENMP
-#pragma omp parallel
-          {
 #pragma omp for schedule(dynamic, 1)
-#else
-          {
 #endif
-            for (int h = 0; h < n; ++h) {
-              int a = Rs.getX(h);
-              int b = Rs.getY(h);
-
-              double best_v = negeps;
-              double best_c = -1;
-              int best_j = 0;
-
-              for (const auto &p : coprimes) {
-                int v = p.v;
-                int w = p.w;
-                double c_ij = p.c_vw;
-                if (a + v >= 0 && a + v < xmax && b + w >= 0 && b + w < ymax &&
-                    M[ID(a + v, b + w)]) {
-                  int j = H[ID(a + v, b + w)];
-
-                  double violation = c_ij - pi[h] + pi[j];
-                  if (violation < best_v) {
-                    best_v = violation;
-                    best_c = c_ij;
-                    best_j = j;
-                  }
-                }
-              }
-              // Store most violated cuts for element i
-              vars[h].b = best_j;
-              vars[h].c = best_c;
-            }
+        for (int jj = 0; jj < _m; ++jj) {
+          // TODO: Devo ciclare sulla mappa iniziale (x,y)->idx
+          // e usare quel bilancio ai nodi, se "i"  presente nella mappa
+          // devo iterare su cosa?
+          for (const auto &p : Rs.getM()) {
+            auto q = MXY.find(p.first);
+            if (q != MXY.end()) {
+              simplex.addNode(p.second,
+                              W1[q->second] - Ws[jj * N + q->second]);
+            } else
+              simplex.addNode(p.second, 0.0);
           }
 
-          // Take all negative reduced cost variables
-          vnew.clear();
-          for (auto &v : vars) {
-            if (v.c > -1)
-              vnew.push_back(v);
-            v.c = -1;
+          if (unbalanced) {
+            double bb = -tot_w1 + tot_ws[jj];
+            simplex.addNode(n, bb); // Set the node value, it is not a true add
+
+            double c1 = (bb < 0 ? unbal_cost : 0);
+            double c2 = (bb < 0 ? 0 : unbal_cost);
+
+            for (int i = 0; i < n; ++i)
+              simplex.setArcCost(lhs_arcs[i], c1);
+
+            for (int i = 0; i < n; ++i)
+              simplex.setArcCost(rhs_arcs[i], c2);
           }
 
-          auto end_tt = std::chrono::steady_clock::now();
-          _all_p +=
-              double(std::chrono::duration_cast<std::chrono::milliseconds>(
-                         end_tt - start_tt)
-                         .count()) /
-              1000;
+          int it = 0;
+
+          // Init the simplex
+          simplex.initColumnPool(pool_age);
+          simplex.run(pivotRule());
+
+          // Start separation
+          ProblemType st;
+          while (true) {
+            st = simplex.reRun(pivotRule());
+            if (st == ProblemType::TIMELIMIT || st == ProblemType::CANCELLED)
+              break;
 
-          if (vnew.empty())
-            break;
+            // Take the dual values
+            for (int j = 0; j < n; ++j)
+              pi[j] = -simplex.potential(j);
 
-          std::sort(vnew.begin(), vnew.end(),
-                    [](const Var &v, const Var &w) { return v.c > w.c; });
+            // Solve separation problem:
+            separateColumns(Rs, xmax, ymax, G, pi, negeps, vars, vnew);
 
-          // Replace old constraints with new ones
-          int new_arcs = simplex.updateArcs(vnew);
+            if (vnew.empty())
+              break;
 
-          n_cuts += new_arcs;
+            // Replace old constraints with new ones
+            simplex.addColumns(vnew);
 
-          ++it;
-        }
+            ++it;
+          }
+          if (st != ProblemType::OPTIMAL)
+            status = st;
 
-        _iterations += simplex.iterations();
-        _num_arcs = simplex.num_arcs();
-        _num_nodes = simplex.num_nodes();
-        auto end_t = std::chrono::steady_clock::now();
-        auto _all = double(std::chrono::duration_cast<std::chrono::nanoseconds>(
-                               end_t - start_t)
-                               .count()) /
-                    1000000000;
+          iterations += simplex.iterations();
+          stats += simplex.stats();
+          pool_stats += simplex.poolStats();
 
-        Ds[jj] = simplex.totalCost();
-        if (unbalanced)
-          Ds[jj] = Ds[jj] / std::max(tot_w1, tot_ws[jj]);
+          Ds[jj] = simplex.totalCost();
+          if (unbalanced)
+            Ds[jj] = Ds[jj] / std::max(tot_w1, tot_ws[jj]);
+          its[jj] = it;
+        }
 
-        if (_n_log > 0)
-          PRINT("it: %d, fobj: %f, all: %f, simplex: %f, all_p: %f\n", it,
-                Ds[jj], _all, _runtime, _all_p);
+#ifdef _OPENMP
+#pragma omp critical(kwd_batch_stats)
+#endif
+        {
+          _iterations += iterations;
+          _stats += stats;
+          _pool_stats += pool_stats;
+          _num_arcs = std::max(_num_arcs, simplex.num_arcs());
+          if (status != ProblemType::OPTIMAL)
+            _status = status;
+        }
       }
+
+      if (_n_log > 0)
+        for (int jj = 0; jj < _m; ++jj)
+          PRINT("it: %d, fobj: %f, target: %d\n", its[jj], Ds[jj], jj);
+
       auto end_t = std::chrono::steady_clock::now();
       auto _all = double(std::chrono::duration_cast<std::chrono::nanoseconds>(
                              end_t - start_t)
@@ -2405,7 +2705,7 @@ public:
     // Set the coprimes set
     if (LL != L) {
       L = LL;
-      init_coprimes(LL); // TODO: make it parallel
+      init_coprimes(LL);
     }
 
     // Return value
@@ -2426,10 +2726,20 @@ public:
       Rs = ch.FillHull(ps);
     }
 
+    Rs.reorder(node_order);
+
     int n = static_cast<int>(Rs.size());
 
+    // All the pairs, row by row
+    std::vector<std::pair<int, int>> pairs;
+    for (int ii = 0; ii < _m; ++ii)
+      for (int jj = ii + 1; jj < _m; ++jj)
+        pairs.emplace_back(ii, jj);
+    int np = static_cast<int>(pairs.size());
+
     // Second option for algorithm
-    if (algorithm == KWD_VAL_MINCOSTFLOW) {
+    if (algorithm == KWD_VAL_MINCOSTFLOW ||
+        algorithm == KWD_VAL_COSTSCALING) {
       // Compute xmax, ymax for each axis
       int xmin = std::numeric_limits<int>::max();
       int ymin = std::numeric_limits<int>::max();
@@ -2444,16 +2754,148 @@ public:
       xmax++;
       ymax++;
 
-      // Binary vector for positions
-      auto ID = [&ymax](int x, int y) { return x * ymax + y; };
+      // Cost scaling on a single network, pair after pair
+      if (algorithm == KWD_VAL_COSTSCALING) {
+        std::vector<double> Ps(np), Es(np);
+        solveCostScaling(
+            Rs, xmin, ymin, xmax, ymax, np,
+            [&](int k, std::vector<double> &B) {
+              int ii = pairs[k].first;
+              int jj = pairs[k].second;
+              for (const auto &p : Rs.getM()) {
+                auto q = MXY.find(p.first);
+                if (q != MXY.end())
+                  B[p.second] = Ws[ii * N + q->second] - Ws[jj * N + q->second];
+                else
+                  B[p.second] = 0.0;
+              }
+              if (unbalanced)
+                B[n] = -tot_ws[ii] + tot_ws[jj];
+            },
+            Ps, Es);
+
+        _error_bound = 0.0;
+        for (int k = 0; k < np; ++k) {
+          int ii = pairs[k].first;
+          int jj = pairs[k].second;
+          if (unbalanced && Ps[k] != std::numeric_limits<double>::max()) {
+            Ps[k] = Ps[k] / std::max(tot_ws[ii], tot_ws[jj]);
+            Es[k] = Es[k] / std::max(tot_ws[ii], tot_ws[jj]);
+          }
+          _error_bound = std::max(_error_bound, Es[k]);
+          Ds[ii * _m + jj] = Ps[k];
+          Ds[jj * _m + ii] = Ps[k];
+        }
+        return Ds;
+      }
 
-      std::vector<bool> M(size_t(xmax) * size_t(ymax), false);
-      for (int i = 0; i < n; ++i)
-        M[ID(Rs.getX(i), Rs.getY(i))] = true;
+      // Unbalanced transport on the capacitated network
+      if (unbalanced && capacitated) {
+        std::vector<double> Ps(np), Es(np);
+        solveCapacitated<double, double>(
+            Rs, xmin, ymin, xmax, ymax, np,
+            [&](int k, std::vector<double> &B) {
+              int ii = pairs[k].first;
+              int jj = pairs[k].second;
+              for (const auto &p : Rs.getM()) {
+                auto q = MXY.find(p.first);
+                if (q != MXY.end())
+                  B[p.second] = Ws[ii * N + q->second] - Ws[jj * N + q->second];
+                else
+                  B[p.second] = 0.0;
+              }
+              B[n] = -tot_ws[ii] + tot_ws[jj];
+            },
+            Ps, Es);
+
+        for (int k = 0; k < np; ++k) {
+          int ii = pairs[k].first;
+          int jj = pairs[k].second;
+          Ds[ii * _m + jj] = Ps[k] / std::max(tot_ws[ii], tot_ws[jj]);
+          Ds[jj * _m + ii] = Ds[ii * _m + jj];
+        }
+        return Ds;
+      }
 
-      std::vector<int> H(size_t(xmax) * size_t(ymax), 0);
-      for (int i = 0; i < n; ++i)
-        H[ID(Rs.getX(i), Rs.getY(i))] = i;
+      // Graph with implicit arcs, without the unbalanced node: the threads
+      // share the network, and every pair is solved from scratch
+      if (implicit_arcs && !unbalanced) {
+        typedef double CostType;
+        auto net = gridNetwork<CostType>(Rs, xmax, ymax);
+
+        checkImplicitArcs();
+        _status = ProblemType::OPTIMAL;
+        _error_bound = 0.0;
+        _num_arcs = net->num_arcs();
+        _num_nodes = n;
+
+        if (verbosity == KWD_VAL_INFO)
+          PRINT("INFO: NetSimplexGrid with V=%d and E=%ld (implicit)\n", n,
+                _num_arcs);
+
+        int workers = batchThreads(np);
+        std::vector<ProblemType> sts(np, ProblemType::OPTIMAL);
+
+#ifdef _OPENMP
+#pragma omp parallel num_threads(workers)
+#endif
+        {
+          NetSimplexGrid<double, CostType> simplex(net);
+          setupBatchSolver(simplex, workers);
+
+          double runtime = 0.0;
+          uint64_t iterations = 0;
+          SimplexStats stats;
+          ProblemType status = ProblemType::OPTIMAL;
+
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 1)
+#endif
+          for (int k = 0; k < np; ++k) {
+            int ii = pairs[k].first;
+            int jj = pairs[k].second;
+            for (const auto &p : Rs.getM()) {
+              auto q = MXY.find(p.first);
+              if (q != MXY.end())
+                simplex.addNode(p.second, Ws[ii * N + q->second] -
+                                              Ws[jj * N + q->second]);
+              else
+                simplex.addNode(p.second, 0.0);
+            }
+
+            ProblemType st = simplex.run();
+
+            runtime += simplex.runtime();
+            iterations += simplex.iterations();
+            stats += simplex.stats();
+
+            // Every pair writes its own two entries of Ds
+            Ds[ii * _m + jj] = std::numeric_limits<CostType>::max();
+            sts[k] = st;
+            if (st != ProblemType::INFEASIBLE &&
+                st != ProblemType::UNBOUNDED &&
+                st != ProblemType::TIMELIMIT && st != ProblemType::CANCELLED)
+              Ds[ii * _m + jj] = simplex.totalCost();
+            else
+              status = st;
+            Ds[jj * _m + ii] = Ds[ii * _m + jj];
+          }
+
+#ifdef _OPENMP
+#pragma omp critical(kwd_batch_stats)
+#endif
+          {
+            _runtime += runtime;
+            _iterations += iterations;
+            _stats += stats;
+            if (status != ProblemType::OPTIMAL)
+              _status = status;
+          }
+        }
+        logBatchErrors(sts);
+
+        return Ds;
+      }
 
       // Serve questo passaggio?
       // Rs.merge(ps); // CHECK: Posso mettere i pesi direttamente
@@ -2461,51 +2903,60 @@ public:
 
       typedef double FlowType;
       typedef double CostType;
-      // Build the graph for min cost flow
-      NetSimplex<FlowType, CostType> simplex(
-          'F', n + int(unbalanced == true),
-          n *static_cast<int>(coprimes.size()));
 
-      // Set the parameters
-      simplex.setTimelimit(timelimit);
-      simplex.setVerbosity(verbosity);
-      simplex.setOptTolerance(opt_tolerance);
+      auto arcs = gridArcs<CostType>(Rs, xmin, ymin, xmax, ymax, 1.0);
 
-      // Initial set of arcs
-      for (int h = 0; h < n; ++h) {
-        int i = Rs.getX(h);
-        int j = Rs.getY(h);
-        for (const auto &p : coprimes) {
-          int v = p.v;
-          int w = p.w;
-          if (i + v >= xmin && i + v < xmax && j + w >= ymin && j + w < ymax &&
-              M[ID(i + v, j + w)]) {
-            int ff = H[ID(i + v, j + w)];
-            simplex.addArc(h, ff, p.c_vw);
-          }
-        }
-      }
+      if (verbosity == KWD_VAL_INFO)
+        PRINT("INFO: running NetSimplex with V=%d and %d threads\n",
+              n + int(unbalanced == true), batchThreads(np));
 
-      // Add noded for unbalanced transport, if parater is set
-      vector<size_t> lhs_arcs(n, 0);
-      vector<size_t> rhs_arcs(n, 0);
-      if (unbalanced) {
-        for (int i = 0; i < n; ++i)
-          lhs_arcs[i] = simplex.addArc(i, n, 0);
+      _status = ProblemType::OPTIMAL;
+      _num_nodes = n + int(unbalanced == true);
 
-        for (int i = 0; i < n; ++i)
-          rhs_arcs[i] = simplex.addArc(n, i, 0);
-      }
+      int workers = batchThreads(np);
+      std::vector<ProblemType> sts(np, ProblemType::OPTIMAL);
 
-      // Model attributes
-      _num_arcs = simplex.num_arcs();
+      // The pairs are spread among the threads: the threads share the arcs
+      // of the grid, and every thread has its own network simplex with the
+      // flows, the spanning tree and the arcs of the unbalanced node. The
+      // chunks keep close pairs on the same thread for the warm starts
+#ifdef _OPENMP
+#pragma omp parallel num_threads(workers)
+#endif
+      {
+        // Build the graph for min cost flow
+        auto &simplex = pooledSimplex<FlowType, CostType>(
+            'F', n + int(unbalanced == true), unbalanced ? 2 * n : 0);
 
-      if (verbosity == KWD_VAL_INFO)
-        PRINT("INFO: running NetSimplex with V=%ld and E=%ld\n",
-              simplex.num_nodes(), simplex.num_arcs());
+        // Set the parameters
+        setupBatchSolver(simplex, workers);
+
+        // Initial set of arcs
+        simplex.addArcs(arcs);
+
+        // Add noded for unbalanced transport, if parater is set
+        vector<size_t> lhs_arcs(n, 0);
+        vector<size_t> rhs_arcs(n, 0);
+        if (unbalanced) {
+          for (int i = 0; i < n; ++i)
+            lhs_arcs[i] = simplex.addArc(i, n, 0);
+
+          for (int i = 0; i < n; ++i)
+            rhs_arcs[i] = simplex.addArc(n, i, 0);
+        }
+
+        double runtime = 0.0;
+        uint64_t iterations = 0;
+        SimplexStats stats;
+        ProblemType status = ProblemType::OPTIMAL;
+        bool warm = false;
 
-      for (int ii = 0; ii < _m; ++ii) {
-        for (int jj = ii + 1; jj < _m; ++jj) {
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 8)
+#endif
+        for (int k = 0; k < np; ++k) {
+          int ii = pairs[k].first;
+          int jj = pairs[k].second;
           // TODO: Devo ciclare sulla mappa iniziale (x,y)->idx
           // e usare quel bilancio ai nodi, se "i"  presente
           // nella mappa devo iterare su cosa?
@@ -2526,37 +2977,55 @@ public:
             double c2 = (bb < 0 ? 0 : unbal_cost);
 
             for (int i = 0; i < n; ++i)
-              simplex.setArcCost(i, c1);
+              simplex.setArcCost(lhs_arcs[i], c1);
 
             for (int i = 0; i < n; ++i)
-              simplex.setArcCost(i, c2);
+              simplex.setArcCost(rhs_arcs[i], c2);
           }
 
-          _num_nodes = simplex.num_nodes();
-
           // Solve the problem to compute the distance
-          _status = simplex.run();
-
-          _runtime += simplex.runtime();
-          _iterations += simplex.iterations();
-
+          ProblemType st;
+          if (warm && warm_start == KWD_VAL_PRIMAL)
+            st = simplex.warmRun(pivotRule());
+          else if (warm && warm_start == KWD_VAL_DUAL)
+            st = simplex.dualRun(pivotRule());
+          else
+            st = simplex.run(pivotRule());
+          warm = true;
+
+          runtime += simplex.runtime();
+          iterations += simplex.iterations();
+          stats += simplex.stats();
+
+          // Every pair writes its own two entries of Ds
           Ds[ii * _m + jj] = std::numeric_limits<CostType>::max();
           Ds[jj * _m + ii] = std::numeric_limits<CostType>::max();
+          sts[k] = st;
 
-          if (_status != ProblemType::INFEASIBLE &&
-              _status != ProblemType::UNBOUNDED &&
-              _status != ProblemType::TIMELIMIT) {
+          if (st != ProblemType::INFEASIBLE && st != ProblemType::UNBOUNDED &&
+              st != ProblemType::TIMELIMIT && st != ProblemType::CANCELLED) {
             Ds[ii * _m + jj] = simplex.totalCost();
             if (unbalanced)
               Ds[ii * _m + jj] =
                   Ds[ii * _m + jj] / std::max(tot_ws[ii], tot_ws[jj]);
             Ds[jj * _m + ii] = Ds[ii * _m + jj];
           } else
-            PRINT("ERROR 1001: Network Simplex wrong. Error code: "
-                  "%d\n",
-                  (int)_status);
+            status = st;
+        }
+
+#ifdef _OPENMP
+#pragma omp critical(kwd_batch_stats)
+#endif
+        {
+          _runtime += runtime;
+          _iterations += iterations;
+          _stats += stats;
+          _num_arcs = simplex.num_arcs();
+          if (status != ProblemType::OPTIMAL)
+            _status = status;
         }
       }
+      logBatchErrors(sts);
 
       return Ds;
     }
@@ -2564,7 +3033,6 @@ public:
     // Second option for algorithm
     if (algorithm == KWD_VAL_COLGEN) {
       auto start_t = std::chrono::steady_clock::now();
-      double _all_p = 0.0;
 
       // Compute xmax, ymax for each axis
       int xmax = std::numeric_limits<int>::min();
@@ -2579,49 +3047,71 @@ public:
 
       if (LL != L) {
         L = LL;
-        init_coprimes(LL); // TODO: make it parallel
+        init_coprimes(LL);
       }
 
-      // Binary vector for positions
-      auto ID = [&ymax](int x, int y) { return x * ymax + y; };
-
-      std::vector<bool> M(size_t(xmax) * size_t(ymax), false);
-      for (int i = 0; i < n; ++i)
-        M[ID(Rs.getX(i), Rs.getY(i))] = true;
-
-      std::vector<int> H(size_t(xmax) * size_t(ymax), 0);
-      for (int i = 0; i < n; ++i)
-        H[ID(Rs.getX(i), Rs.getY(i))] = i;
+      // Index of the points on the grid
+      auto G = indexRaster(Rs, xmax, ymax);
 
       typedef double FlowType;
       typedef double CostType;
 
-      // Build the graph for min cost flow
-      NetSimplex<FlowType, CostType> simplex('E', n + int(unbalanced == true),
-                                             0);
+      if (verbosity == KWD_VAL_INFO)
+        PRINT("INFO: running NetSimplex with V=%d and E=%d\n",
+              n + int(unbalanced == true), unbalanced ? 2 * n : 0);
 
-      // Set the parameters
-      simplex.setTimelimit(timelimit);
-      simplex.setVerbosity(verbosity);
-      simplex.setOptTolerance(opt_tolerance);
+      _status = ProblemType::OPTIMAL;
+      _pool_stats = ColumnPoolStats();
+      _num_nodes = n + int(unbalanced == true);
+      _num_arcs = 0;
 
-      // Add noded for unbalanced transport, if parater is set
-      vector<size_t> lhs_arcs(n, 0);
-      vector<size_t> rhs_arcs(n, 0);
-      if (unbalanced) {
-        for (int i = 0; i < n; ++i)
-          lhs_arcs[i] = simplex.addArc(i, n, 0);
+      int workers = batchThreads(np);
+      std::vector<int> its(np, 0);
 
-        for (int i = 0; i < n; ++i)
-          rhs_arcs[i] = simplex.addArc(n, i, 0);
-      }
+      // The pairs are spread among the threads: every thread has its own
+      // network simplex, while Rs, G and the coprimes are shared
+#ifdef _OPENMP
+#pragma omp parallel num_threads(workers)
+#endif
+      {
+        // Build the graph for min cost flow
+        auto &simplex = pooledSimplex<FlowType, CostType>(
+            'E', n + int(unbalanced == true), 0);
 
-      if (verbosity == KWD_VAL_INFO)
-        PRINT("INFO: running NetSimplex with V=%ld and E=%ld\n",
-              simplex.num_nodes(), simplex.num_arcs());
+        // Set the parameters
+        setupBatchSolver(simplex, workers);
+
+        // Add noded for unbalanced transport, if parater is set
+        vector<size_t> lhs_arcs(n, 0);
+        vector<size_t> rhs_arcs(n, 0);
+        if (unbalanced) {
+          for (int i = 0; i < n; ++i)
+            lhs_arcs[i] = simplex.addArc(i, n, 0);
+
+          for (int i = 0; i < n; ++i)
+            rhs_arcs[i] = simplex.addArc(n, i, 0);
+        }
+
+        uint64_t iterations = 0;
+        SimplexStats stats;
+        ColumnPoolStats pool_stats;
+        ProblemType status = ProblemType::OPTIMAL;
 
-      for (int ii = 0; ii < _m; ++ii) {
-        for (int jj = ii + 1; jj < _m; ++jj) {
+        double negeps = std::nextafter(-opt_tolerance, -0.0);
+
+        vector<double> pi(n, 0);
+
+        Vars vars;
+
+        Vars vnew;
+        vnew.reserve(n);
+
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 1)
+#endif
+        for (int k = 0; k < np; ++k) {
+          int ii = pairs[k].first;
+          int jj = pairs[k].second;
           // TODO: Devo ciclare sulla mappa iniziale (x,y)->idx
           // e usare quel bilancio ai nodi, se "i"  presente
           // nella mappa devo iterare su cosa?
@@ -2642,35 +3132,23 @@ public:
             double c2 = (bb < 0 ? 0 : unbal_cost);
 
             for (int i = 0; i < n; ++i)
-              simplex.setArcCost(i, c1);
+              simplex.setArcCost(lhs_arcs[i], c1);
 
             for (int i = 0; i < n; ++i)
-              simplex.setArcCost(i, c2);
+              simplex.setArcCost(rhs_arcs[i], c2);
           }
 
-          _num_nodes = simplex.num_nodes();
-
           int it = 0;
-          int n_cuts = 0;
-          // CostType fobj = 0;
-          double negeps = std::nextafter(-opt_tolerance, -0.0);
-
-          vector<double> pi(n, 0);
-
-          Vars vars(n);
-          for (int i = 0; i < n; ++i)
-            vars[i].a = i;
-
-          Vars vnew;
-          vnew.reserve(n);
 
           // Init the simplex
-          simplex.run();
+          simplex.initColumnPool(pool_age);
+          simplex.run(pivotRule());
 
           // Start separation
+          ProblemType st;
           while (true) {
-            _status = simplex.reRun();
-            if (_status == ProblemType::TIMELIMIT)
+            st = simplex.reRun(pivotRule());
+            if (st == ProblemType::TIMELIMIT || st == ProblemType::CANCELLED)
               break;
 
             // Take the dual values
@@ -2678,93 +3156,52 @@ public:
               pi[j] = -simplex.potential(j);
 
             // Solve separation problem:
-            auto start_tt = std::chrono::steady_clock::now();
-#pragma omp parallel
-            {
-#pragma omp for schedule(dynamic, 1)
-              for (int h = 0; h < n; ++h) {
-                int a = Rs.getX(h);
-                int b = Rs.getY(h);
-
-                double best_v = negeps;
-                double best_c = -1;
-                int best_j = 0;
-
-                for (const auto &p : coprimes) {
-                  int v = p.v;
-                  int w = p.w;
-                  double c_ij = p.c_vw;
-                  if (a + v >= 0 && a + v < xmax && b + w >= 0 &&
-                      b + w < ymax && M[ID(a + v, b + w)]) {
-                    int j = H[ID(a + v, b + w)];
-
-                    double violation = c_ij - pi[h] + pi[j];
-                    if (violation < best_v) {
-                      best_v = violation;
-                      best_c = c_ij;
-                      best_j = j;
-                    }
-                  }
-                }
-                // Store most violated cuts for element i
-                vars[h].b = best_j;
-                vars[h].c = best_c;
-              }
-            }
-
-            // Take all negative reduced cost variables
-            vnew.clear();
-            for (auto &v : vars) {
-              if (v.c > -1)
-                vnew.push_back(v);
-              v.c = -1;
-            }
-
-            auto end_tt = std::chrono::steady_clock::now();
-            _all_p +=
-                double(std::chrono::duration_cast<std::chrono::milliseconds>(
-                           end_tt - start_tt)
-                           .count()) /
-                1000;
+            separateColumns(Rs, xmax, ymax, G, pi, negeps, vars, vnew);
 
             if (vnew.empty())
               break;
 
-            std::sort(vnew.begin(), vnew.end(),
-                      [](const Var &v, const Var &w) { return v.c > w.c; });
-
             // Replace old constraints with new ones
-            int new_arcs = simplex.updateArcs(vnew);
-
-            n_cuts += new_arcs;
+            simplex.addColumns(vnew);
 
             ++it;
           }
+          if (st != ProblemType::OPTIMAL)
+            status = st;
 
-          _iterations += simplex.iterations();
-          _num_arcs = simplex.num_arcs();
-          _num_nodes = simplex.num_nodes();
-          auto end_t = std::chrono::steady_clock::now();
-          auto _all =
-              double(std::chrono::duration_cast<std::chrono::nanoseconds>(
-                         end_t - start_t)
-                         .count()) /
-              1000000000;
+          iterations += simplex.iterations();
+          stats += simplex.stats();
+          pool_stats += simplex.poolStats();
 
+          // Every pair writes its own two entries of Ds
           Ds[jj * _m + ii] = simplex.totalCost();
           if (unbalanced)
             Ds[jj * _m + ii] =
                 Ds[jj * _m + ii] / std::max(tot_ws[ii], tot_ws[jj]);
 
           Ds[ii * _m + jj] = Ds[jj * _m + ii];
+          its[k] = it;
+        }
 
-          if (_n_log > 0)
-            PRINT("it: %d, fobj: %f, all: %f, simplex: %f, all_p: "
-                  "%f\n",
-                  it, Ds[jj * _m + ii], _all, _runtime, _all_p);
+#ifdef _OPENMP
+#pragma omp critical(kwd_batch_stats)
+#endif
+        {
+          _iterations += iterations;
+          _stats += stats;
+          _pool_stats += pool_stats;
+          _num_arcs = std::max(_num_arcs, simplex.num_arcs());
+          if (status != ProblemType::OPTIMAL)
+            _status = status;
         }
       }
 
+      if (_n_log > 0)
+        for (int k = 0; k < np; ++k)
+          PRINT("it: %d, fobj: %f, pair: (%d, %d)\n", its[k],
+                Ds[pairs[k].second * _m + pairs[k].first], pairs[k].first,
+                pairs[k].second);
+
       auto end_t = std::chrono::steady_clock::now();
       auto _all = double(std::chrono::duration_cast<std::chrono::nanoseconds>(
                              end_t - start_t)
@@ -2833,20 +3270,1162 @@ public:
   }
 
 private:
-  // Merge two historgram into a PointCloud
-  PointCloud2D mergeHistograms(const Histogram2D &A, const Histogram2D &B) {
-    int xmin = std::numeric_limits<int>::max();
-    int ymin = std::numeric_limits<int>::max();
-    for (const auto &p : A) {
-      xmin = std::min(xmin, p.first.first);
-      ymin = std::min(ymin, p.first.second);
-    }
-    for (const auto &p : B) {
-      xmin = std::min(xmin, p.first.first);
-      ymin = std::min(ymin, p.first.second);
-    }
-
-    PointCloud2D Rs;
+  // Check and recode the input histograms of a one-to-one comparison, and
+  // merge the weights of the repeated bins: Xs and Ys get the coordinates
+  // shifted to (0,0), and W1 and W2 the weights, normalized unless the
+  // problem is unbalanced, with totals tot_w1 and tot_w2
+  void prepareInput(int _n, int *_Xs, int *_Ys, double *_W1, double *_W2,
+                    vector<int> &Xs, vector<int> &Ys, vector<double> &W1,
+                    vector<double> &W2, double &tot_w1, double &tot_w2) {
+    // Check for correct input
+    if (check_coding(_n, _Xs))
+      PRINT(
+          "WARNING: the Xs input coordinates are not consecutives integers.\n");
+    if (check_coding(_n, _Ys))
+      PRINT(
+          "WARNING: the Ys input coordinates are not consecutives integers.\n");
+
+    if (recode != "") {
+      PRINT("INFO: Recoding the input coordinates to consecutive integers.\n");
+      recoding(_n, _Xs);
+      recoding(_n, _Ys);
+    }
+
+    if (verbosity == KWD_VAL_INFO)
+      dumpParam();
+    intpair2int XY = reindex(_n, _Xs, _Ys);
+    int n = XY.size();
+
+    Xs.assign(n, 0);
+    Ys.assign(n, 0);
+    W1.assign(n, 0);
+    W2.assign(n, 0);
+    for (int i = 0; i < _n; i++) {
+      int idx = XY[int_pair(_Xs[i], _Ys[i])];
+      Xs[idx] = _Xs[i];
+      Ys[idx] = _Ys[i];
+      W1[idx] += _W1[i];
+      W2[idx] += _W2[i];
+      if (_W1[i] < 0.0) {
+        PRINT("WARNING: weight W1[%d]=%.4f is negative. Only positive weights "
+              "are allowed.\n",
+              i, _W1[i]);
+        throw std::runtime_error(
+            "FATAL ERROR: Input histogram with negative weigths");
+      }
+      if (_W2[i] < 0.0) {
+        PRINT("WARNING: weight W2[%d]=%.4f is negative. Only positive weights "
+              "are allowed.\n",
+              i, _W2[i]);
+        throw std::runtime_error(
+            "FATAL ERROR: Input histogram with negative weigths");
+      }
+    }
+
+    // Get the largest bounding box
+    auto xy = getMinMax(n, &Xs[0], &Ys[0]);
+
+    int xmin = xy[0];
+    int ymin = xy[1];
+
+    // Rescale all integers coordinates to (0,0)
+    tot_w1 = 0.0;
+    tot_w2 = 0.0;
+    for (int i = 0; i < n; ++i) {
+      Xs[i] = Xs[i] - xmin;
+      Ys[i] = Ys[i] - ymin;
+
+      tot_w1 += W1[i];
+      tot_w2 += W2[i];
+    }
+
+    // Rebalance the total mass only if it is not an unbalanced probelm
+    if (!unbalanced) {
+      for (int i = 0; i < n; ++i) {
+        W1[i] = W1[i] / tot_w1;
+        W2[i] = W2[i] / tot_w2;
+      }
+    }
+  }
+
+  // Network simplex of the calling thread for the given number types, reset
+  // for the new problem: it is kept across calls to reuse its memory
+  template <typename FlowType, typename CostType>
+  NetSimplex<FlowType, CostType> &pooledSimplex(const char INIT, int node_num,
+                                                int arc_num) {
+    typedef NetSimplex<FlowType, CostType> Simplex;
+    int t = 0;
+#ifdef _OPENMP
+    t = omp_get_thread_num();
+#endif
+    std::shared_ptr<void> *slot;
+#ifdef _OPENMP
+#pragma omp critical(kwd_simplex_pool)
+#endif
+    slot = &_pool.slots[std::make_pair(std::type_index(typeid(Simplex)), t)];
+
+    if (!*slot) {
+      *slot = std::make_shared<Simplex>(INIT, node_num, arc_num);
+      return *static_cast<Simplex *>(slot->get());
+    }
+    Simplex &simplex = *static_cast<Simplex *>(slot->get());
+    simplex.reset(INIT, node_num, arc_num);
+    return simplex;
+  }
+
+  // Number of threads for a batch of m targets
+  int batchThreads(int m) const {
+    return (std::max)(1, (std::min)(batch_threads, m));
+  }
+
+  // Map the pivot rule parameter to the network simplex pivot rule
+  PivotRule pivotRule() const {
+    if (pivot_rule == KWD_VAL_CANDIDATELIST)
+      return PivotRule::CANDIDATE_LIST;
+    if (pivot_rule == KWD_VAL_ALTERINGLIST)
+      return PivotRule::ALTERING_LIST;
+    if (pivot_rule == KWD_VAL_ADAPTIVEBLOCK)
+      return PivotRule::ADAPTIVE_BLOCK_SEARCH;
+    return PivotRule::BLOCK_SEARCH;
+  }
+
+  // Solve the L-approximation model of Rs storing all the arcs, with the
+  // given flow and cost types
+  template <typename FlowType, typename CostType>
+  double solveFullModel(const PointCloud2D &Rs, int xmin, int ymin, int xmax,
+                        int ymax, double tot_w1, double tot_w2) {
+    // Unbalanced transport on the capacitated network
+    if (unbalanced && capacitated) {
+      std::vector<double> Ds(1), Es(1);
+      _runtime = 0.0;
+      _iterations = 0;
+      solveCapacitated<FlowType, CostType>(
+          Rs, xmin, ymin, xmax, ymax, 1,
+          [&Rs](int, std::vector<double> &B) {
+            int n = static_cast<int>(Rs.size());
+            for (int i = 0; i < n; ++i)
+              B[i] = Rs.getB(i);
+            B[n] = -Rs.balance();
+          },
+          Ds, Es);
+      _error_bound = Es[0] / std::max(tot_w1, tot_w2);
+      return Ds[0] / std::max(tot_w1, tot_w2);
+    }
+
+    int n = static_cast<int>(Rs.size());
+
+    // Binary vector for positions
+    auto ID = [&ymax](int x, int y) { return x * ymax + y; };
+
+    std::vector<bool> M(size_t(xmax) * size_t(ymax), false);
+    for (int i = 0; i < n; ++i)
+      M[ID(Rs.getX(i), Rs.getY(i))] = true;
+
+    std::vector<int> H(size_t(xmax) * size_t(ymax), 0);
+    for (int i = 0; i < n; ++i)
+      H[ID(Rs.getX(i), Rs.getY(i))] = i;
+
+    // Build the graph for min cost flow
+    auto &simplex = pooledSimplex<FlowType, CostType>(
+        'F', n + int(unbalanced == true),
+        n *static_cast<int>(coprimes.size()));
+
+    // Set the parameters
+    simplex.setTimelimit(timelimit);
+    simplex.setCancelToken(cancel_token);
+    simplex.setVerbosity(verbosity);
+    simplex.setOptTolerance(optTolerance<CostType>());
+    simplex.setThreads(threads);
+
+    // add first d source nodes
+    std::vector<double> B(n + int(unbalanced == true));
+    for (int i = 0; i < n; ++i)
+      B[i] = Rs.getB(i);
+    if (unbalanced)
+      B[n] = -Rs.balance();
+
+    double mass_scale = 1.0;
+    std::vector<FlowType> Q = scaleSupplies<FlowType>(B, mass_scale);
+    double cost_scale = costScale<CostType>(n);
+
+    for (int i = 0; i < n; ++i)
+      simplex.addNode(i, Q[i]);
+
+    for (int h = 0; h < n; ++h) {
+      int i = Rs.getX(h);
+      int j = Rs.getY(h);
+      for (const auto &p : coprimes) {
+        int v = p.v;
+        int w = p.w;
+        if (i + v >= xmin && i + v < xmax && j + w >= ymin && j + w < ymax &&
+            M[ID(i + v, j + w)]) {
+          int ff = H[ID(i + v, j + w)];
+          simplex.addArc(h, ff, scaleCost<CostType>(p.c_vw, cost_scale));
+        }
+      }
+    }
+
+    // Add noded for unbalanced transport, if parater is set
+    if (unbalanced) {
+      double bb = B[n];
+      CostType c1 = scaleCost<CostType>(bb < 0 ? unbal_cost : 0, cost_scale);
+      CostType c2 = scaleCost<CostType>(bb < 0 ? 0 : unbal_cost, cost_scale);
+      simplex.addNode(n, Q[n]);
+
+      for (int i = 0; i < n; ++i)
+        simplex.addArc(i, n, c1);
+
+      for (int i = 0; i < n; ++i)
+        simplex.addArc(n, i, c2);
+    }
+
+    // Solve the problem to compute the distance
+    if (verbosity == KWD_VAL_INFO)
+      PRINT("INFO: running NetSimplex with V=%ld and E=%ld\n",
+            simplex.num_nodes(), simplex.num_arcs());
+    _status = simplex.run(pivotRule());
+
+    _runtime = simplex.runtime();
+    _iterations = simplex.iterations();
+    _stats = simplex.stats();
+    _num_arcs = simplex.num_arcs();
+    _num_nodes = simplex.num_nodes();
+
+    double distance = std::numeric_limits<double>::max();
+
+    if (_status != ProblemType::INFEASIBLE &&
+        _status != ProblemType::UNBOUNDED &&
+        _status != ProblemType::TIMELIMIT &&
+        _status != ProblemType::CANCELLED)
+      distance = simplex.template totalCost<double>() /
+                 (mass_scale * cost_scale);
+
+    _error_bound =
+        errorBound<CostType>(n, xmin, ymin, xmax, ymax, mass_scale, cost_scale);
+
+    if (unbalanced) {
+      distance = distance / std::max(tot_w1, tot_w2);
+      _error_bound = _error_bound / std::max(tot_w1, tot_w2);
+    }
+
+    return distance;
+  }
+
+  // Solve the L-approximation model of Rs for every target of a one-to-many
+  // comparison storing all the arcs, with the given flow and cost types
+  template <typename FlowType, typename CostType>
+  void solveMinCostFlow(const PointCloud2D &Rs, int xmin, int ymin, int xmax,
+                        int ymax, const intpair2int &MXY,
+                        const vector<double> &W1, const vector<double> &Ws,
+                        int N, int _m, double tot_w1,
+                        const vector<double> &tot_ws, vector<double> &Ds) {
+    int n = static_cast<int>(Rs.size());
+
+    // Unbalanced transport on the capacitated network
+    if (unbalanced && capacitated) {
+      std::vector<double> Es(_m);
+      solveCapacitated<FlowType, CostType>(
+          Rs, xmin, ymin, xmax, ymax, _m,
+          [&](int jj, std::vector<double> &B) {
+            for (const auto &p : Rs.getM()) {
+              auto q = MXY.find(p.first);
+              if (q != MXY.end())
+                B[p.second] = W1[q->second] - Ws[jj * N + q->second];
+              else
+                B[p.second] = 0.0;
+            }
+            B[n] = -tot_w1 + tot_ws[jj];
+          },
+          Ds, Es);
+      _error_bound = 0.0;
+      for (int jj = 0; jj < _m; ++jj) {
+        Ds[jj] = Ds[jj] / std::max(tot_w1, tot_ws[jj]);
+        _error_bound =
+            std::max(_error_bound, Es[jj] / std::max(tot_w1, tot_ws[jj]));
+      }
+      return;
+    }
+
+    // Serve questo passaggio?
+    // Rs.merge(ps); // CHECK: Posso mettere i pesi direttamente sul modello
+
+    double cost_scale = costScale<CostType>(n);
+    auto arcs = gridArcs<CostType>(Rs, xmin, ymin, xmax, ymax, cost_scale);
+
+    if (verbosity == KWD_VAL_INFO)
+      PRINT("INFO: running NetSimplex with V=%d and %d threads\n",
+            n + int(unbalanced == true), batchThreads(_m));
+
+    _status = ProblemType::OPTIMAL;
+    _error_bound = 0.0;
+    _num_nodes = n + int(unbalanced == true);
+
+    int workers = batchThreads(_m);
+    std::vector<ProblemType> sts(_m, ProblemType::OPTIMAL);
+
+    // The targets are split among the threads in contiguous chunks, so that
+    // the warm starts go on within each chunk: the threads share the arcs of
+    // the grid, and every thread has its own network simplex with the flows,
+    // the spanning tree and the arcs of the unbalanced node
+#ifdef _OPENMP
+#pragma omp parallel num_threads(workers)
+#endif
+    {
+      // Build the graph for min cost flow
+      auto &simplex = pooledSimplex<FlowType, CostType>(
+          'F', n + int(unbalanced == true), unbalanced ? 2 * n : 0);
+
+      // Set the parameters
+      setupBatchSolver(simplex, workers, optTolerance<CostType>());
+
+      // Initial set of arcs
+      simplex.addArcs(arcs);
+
+      // Add noded for unbalanced transport, if parater is set
+      vector<size_t> lhs_arcs(n, 0);
+      vector<size_t> rhs_arcs(n, 0);
+      if (unbalanced) {
+        for (int i = 0; i < n; ++i)
+          lhs_arcs[i] = simplex.addArc(i, n, 0);
+
+        for (int i = 0; i < n; ++i)
+          rhs_arcs[i] = simplex.addArc(n, i, 0);
+      }
+
+      double runtime = 0.0;
+      uint64_t iterations = 0;
+      SimplexStats stats;
+      ProblemType status = ProblemType::OPTIMAL;
+      double error_bound = 0.0;
+      bool warm = false;
+
+      std::vector<double> B(n + int(unbalanced == true));
+
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+      for (int jj = 0; jj < _m; ++jj) {
+        // TODO: Devo ciclare sulla mappa iniziale (x,y)->idx
+        // e usare quel bilancio ai nodi, se "i"  presente nella mappa
+        // devo iterare su cosa?
+        for (const auto &p : Rs.getM()) {
+          auto q = MXY.find(p.first);
+          if (q != MXY.end()) {
+            B[p.second] = W1[q->second] - Ws[jj * N + q->second];
+          } else
+            B[p.second] = 0.0;
+        }
+        if (unbalanced)
+          B[n] = -tot_w1 + tot_ws[jj];
+
+        double mass_scale = 1.0;
+        std::vector<FlowType> Q = scaleSupplies<FlowType>(B, mass_scale);
+        for (int i = 0; i < n; ++i)
+          simplex.addNode(i, Q[i]);
+
+        if (unbalanced) {
+          double bb = B[n];
+          simplex.addNode(n, Q[n]); // Set the node value, it is not a true add
+
+          CostType c1 =
+              scaleCost<CostType>(bb < 0 ? unbal_cost : 0, cost_scale);
+          CostType c2 =
+              scaleCost<CostType>(bb < 0 ? 0 : unbal_cost, cost_scale);
+
+          for (int i = 0; i < n; ++i)
+            simplex.setArcCost(lhs_arcs[i], c1);
+
+          for (int i = 0; i < n; ++i)
+            simplex.setArcCost(rhs_arcs[i], c2);
+        }
+
+        // Solve the problem to compute the distance
+        ProblemType st;
+        if (warm && warm_start == KWD_VAL_PRIMAL)
+          st = simplex.warmRun(pivotRule());
+        else if (warm && warm_start == KWD_VAL_DUAL)
+          st = simplex.dualRun(pivotRule());
+        else
+          st = simplex.run(pivotRule());
+        warm = true;
+
+        runtime += simplex.runtime();
+        iterations += simplex.iterations();
+        stats += simplex.stats();
+
+        Ds[jj] = std::numeric_limits<double>::max();
+        sts[jj] = st;
+
+        if (st != ProblemType::INFEASIBLE && st != ProblemType::UNBOUNDED &&
+            st != ProblemType::TIMELIMIT && st != ProblemType::CANCELLED) {
+          Ds[jj] = simplex.template totalCost<double>() /
+                   (mass_scale * cost_scale);
+          double err = errorBound<CostType>(n, xmin, ymin, xmax, ymax,
+                                            mass_scale, cost_scale);
+          if (unbalanced) {
+            Ds[jj] = Ds[jj] / std::max(tot_w1, tot_ws[jj]);
+            err = err / std::max(tot_w1, tot_ws[jj]);
+          }
+          error_bound = std::max(error_bound, err);
+        } else
+          status = st;
+      }
+
+#ifdef _OPENMP
+#pragma omp critical(kwd_batch_stats)
+#endif
+      {
+        _runtime += runtime;
+        _iterations += iterations;
+        _stats += stats;
+        _num_arcs = simplex.num_arcs();
+        _error_bound = std::max(_error_bound, error_bound);
+        if (status != ProblemType::OPTIMAL)
+          _status = status;
+      }
+    }
+    logBatchErrors(sts);
+  }
+
+  // Solve the unbalanced L-approximation model of Rs with the capacitated
+  // network simplex for the m supply vectors set by supplies(k, B), where
+  // B[n] is the supply of the virtual node. The excess mass leaves the
+  // network at its own node (and the missing mass enters at its own node):
+  // the arcs of the virtual node are capped by the supplies and have null
+  // cost, while unbal_cost is charged on the whole excess. This is the
+  // model with big-M costs, when unbal_cost is larger than any path, but
+  // without the big-M costs in the network. Ds and Es get the distances
+  // and the error bounds, not divided by the total mass
+  template <typename FlowType, typename CostType, typename Supplies>
+  void solveCapacitated(const PointCloud2D &Rs, int xmin, int ymin, int xmax,
+                        int ymax, int m, Supplies supplies,
+                        vector<double> &Ds, vector<double> &Es) {
+    int n = static_cast<int>(Rs.size());
+    // The arcs of the unbalanced node have null cost
+    double cost_scale = costScale<CostType>(n, false);
+
+    NetSimplexCapacity<FlowType, CostType> simplex(
+        n + 1, n * static_cast<int>(coprimes.size()) + 2 * n);
+    simplex.setTimelimit(timelimit);
+    simplex.setCancelToken(cancel_token);
+    simplex.setVerbosity(verbosity);
+    simplex.setOptTolerance(optTolerance<CostType>());
+
+    addGridArcs(simplex, Rs, xmin, ymin, xmax, ymax, cost_scale);
+
+    vector<size_t> lhs_arcs(n, 0);
+    vector<size_t> rhs_arcs(n, 0);
+    for (int i = 0; i < n; ++i)
+      lhs_arcs[i] = simplex.addArc(i, n, 0, 0);
+    for (int i = 0; i < n; ++i)
+      rhs_arcs[i] = simplex.addArc(n, i, 0, 0);
+
+    _num_arcs = simplex.num_arcs();
+    _num_nodes = simplex.num_nodes();
+    _stats = SimplexStats();
+
+    if (verbosity == KWD_VAL_INFO)
+      PRINT("INFO: running NetSimplexCapacity with V=%ld and E=%ld\n",
+            simplex.num_nodes(), simplex.num_arcs());
+
+    std::vector<double> B(n + 1);
+    for (int k = 0; k < m; ++k) {
+      supplies(k, B);
+
+      double mass_scale = 1.0;
+      std::vector<FlowType> Q = scaleSupplies<FlowType>(B, mass_scale);
+      for (int i = 0; i <= n; ++i)
+        simplex.addNode(i, Q[i]);
+
+      // Only the arcs in the direction of the excess can carry flow
+      for (int i = 0; i < n; ++i) {
+        simplex.setArcCapacity(lhs_arcs[i], Q[n] < 0 && Q[i] > 0 ? Q[i] : 0);
+        simplex.setArcCapacity(rhs_arcs[i], Q[n] > 0 && Q[i] < 0 ? -Q[i] : 0);
+      }
+
+      _status = simplex.run();
+
+      _runtime += simplex.runtime();
+      _iterations += simplex.iterations();
+
+      Ds[k] = std::numeric_limits<double>::max();
+      Es[k] = 0.0;
+
+      if (_status != ProblemType::INFEASIBLE &&
+          _status != ProblemType::UNBOUNDED &&
+          _status != ProblemType::TIMELIMIT &&
+          _status != ProblemType::CANCELLED) {
+        Ds[k] = simplex.template totalCost<double>() /
+                    (mass_scale * cost_scale) +
+                unbal_cost * std::fabs(B[n]);
+        Es[k] = errorBound<CostType>(n, xmin, ymin, xmax, ymax, mass_scale,
+                                     cost_scale);
+      }
+    }
+  }
+
+  // Separation problem of the column generation: store in vnew, for every
+  // node h of Rs, the pool_columns arcs out of h with the most negative
+  // reduced costs below negeps. The grid has size xmax * ymax, and G is
+  // its index raster. An arc h->j can be violated only if its cost is
+  // below pi[h] - min(pi): only the directions within that radius of h,
+  // and inside the grid, are scanned, so no bound check is needed
+  void separateColumns(const PointCloud2D &Rs, int xmax, int ymax,
+                       const std::vector<int32_t> &G,
+                       const std::vector<double> &pi, double negeps,
+                       Vars &vars, Vars &vnew) const {
+    int n = static_cast<int>(Rs.size());
+    int k = pool_columns;
+    vars.resize(size_t(n) * k);
+
+    double pi_min = n > 0 ? *std::min_element(pi.begin(), pi.begin() + n) : 0;
+    int L = coprimes.maxStep();
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1)
+#endif
+    for (int h = 0; h < n; ++h) {
+      int a = Rs.getX(h);
+      int b = Rs.getY(h);
+
+      // Most violated columns of h, sorted by violation
+      Var *best = &vars[size_t(h) * k];
+      double best_v[KWD_MAX_POOL_COLUMNS];
+      int cnt = 0;
+
+      // Search radius, with a margin of one step for the rounding
+      double R = pi[h] - pi_min;
+      int r = int(std::min(double(L), std::floor(R) + 1));
+
+      for (int v = std::max(-r, -a), v_max = std::min(r, xmax - 1 - a);
+           v <= v_max; ++v) {
+        double q = std::max(0.0, R * R - double(v) * v);
+        int s = int(std::min(double(r), std::floor(std::sqrt(q)) + 1));
+        int w_min = std::max(-s, -b);
+        int w_max = std::min(s, ymax - 1 - b);
+        if (w_min > w_max)
+          continue;
+
+        // Cells of the row a + v, shifted to the column b
+        const int32_t *row = &G[size_t(a + v) * ymax + b];
+
+        auto end = coprimes.rowEnd(v);
+        auto it = std::lower_bound(
+            coprimes.rowBegin(v), end, w_min,
+            [](const coprimes_t &p, int w) { return p.w < w; });
+        for (; it != end && it->w <= w_max; ++it) {
+          const auto &p = *it;
+          int j = row[p.w];
+          if (j >= 0) {
+            double violation = p.c_vw - pi[h] + pi[j];
+            if (violation < negeps &&
+                (cnt < k || violation < best_v[cnt - 1])) {
+              int i = cnt < k ? cnt++ : cnt - 1;
+              for (; i > 0 && best_v[i - 1] > violation; --i) {
+                best_v[i] = best_v[i - 1];
+                best[i] = best[i - 1];
+              }
+              best_v[i] = violation;
+              best[i] = Var(h, j, p.c_vw);
+            }
+          }
+        }
+      }
+      for (int i = cnt; i < k; ++i)
+        best[i].c = -1;
+    }
+
+    // Take all negative reduced cost variables
+    vnew.clear();
+    for (const auto &v : vars)
+      if (v.c > -1)
+        vnew.push_back(v);
+
+    std::sort(vnew.begin(), vnew.end(),
+              [](const Var &v, const Var &w) { return v.c > w.c; });
+  }
+
+  // Index of the point of Rs on every cell of the xmax * ymax grid, -1 for
+  // the empty cells
+  std::vector<int32_t> indexRaster(const PointCloud2D &Rs, int xmax,
+                                   int ymax) const {
+    std::vector<int32_t> G(size_t(xmax) * size_t(ymax), -1);
+    for (int i = 0, n = static_cast<int>(Rs.size()); i < n; ++i)
+      G[size_t(Rs.getX(i)) * ymax + Rs.getY(i)] = i;
+    return G;
+  }
+
+  // Multiscale solve of the L-approximation model of Rs by column
+  // generation: the points are pooled 2x2 into a pyramid, the coarsest level
+  // is solved first, and every finer level starts from the columns lifted
+  // from the coarser one: the arcs along the directions of its flow, and the
+  // arcs with negative reduced cost for its potentials, doubled
+  double solveMultiscale(const PointCloud2D &Rs) {
+    auto start_t = std::chrono::steady_clock::now();
+
+    // Build the pyramid: up[k][i] is the parent at level k+1 of node i
+    std::vector<PointCloud2D> P(1, Rs);
+    std::vector<std::vector<int>> up;
+    while (true) {
+      const PointCloud2D &F = P.back();
+      int side = 0;
+      for (size_t i = 0; i < F.size(); ++i)
+        side = std::max(side, std::max(F.getX(i), F.getY(i)) + 1);
+      if (side <= KWD_MULTISCALE_COARSEST)
+        break;
+
+      PointCloud2D C;
+      for (size_t i = 0; i < F.size(); ++i)
+        C.update(F.getX(i) / 2, F.getY(i) / 2, F.getB(i));
+      C.reorder(node_order);
+
+      std::vector<int> U(F.size());
+      for (size_t i = 0; i < F.size(); ++i)
+        U[i] = int(C.getM().at(std::make_pair(F.getX(i) / 2, F.getY(i) / 2)));
+      up.push_back(std::move(U));
+      P.push_back(std::move(C));
+    }
+
+    typedef double FlowType;
+    typedef double CostType;
+
+    Vars support;
+    vector<double> pi;
+    _iterations = 0;
+    _stats = SimplexStats();
+
+    for (int k = int(P.size()) - 1; k >= 0; --k) {
+      const PointCloud2D &Ls = P[k];
+      int n = int(Ls.size());
+
+      int xmax = 0;
+      int ymax = 0;
+      for (int i = 0; i < n; ++i) {
+        xmax = std::max(xmax, Ls.getX(i) + 1);
+        ymax = std::max(ymax, Ls.getY(i) + 1);
+      }
+
+      auto ID = [&ymax](int x, int y) { return x * ymax + y; };
+
+      auto G = indexRaster(Ls, xmax, ymax);
+
+      auto &simplex = pooledSimplex<FlowType, CostType>(
+          'E', n + int(unbalanced == true), 0);
+
+      double elapsed =
+          double(std::chrono::duration_cast<std::chrono::milliseconds>(
+                     std::chrono::steady_clock::now() - start_t)
+                     .count()) /
+          1000;
+      simplex.setTimelimit(std::max(0.0, timelimit - elapsed));
+      simplex.setCancelToken(cancel_token);
+      simplex.setVerbosity(verbosity);
+      simplex.setOptTolerance(opt_tolerance);
+      simplex.setThreads(threads);
+
+      for (int i = 0; i < n; ++i)
+        simplex.addNode(i, Ls.getB(i));
+
+      if (unbalanced) {
+        double bb = -Ls.balance();
+        double c1 = (bb < 0 ? unbal_cost : 0);
+        double c2 = (bb < 0 ? 0 : unbal_cost);
+        simplex.addNode(n, bb);
+
+        for (int i = 0; i < n; ++i)
+          simplex.addArc(i, n, c1);
+
+        for (int i = 0; i < n; ++i)
+          simplex.addArc(n, i, c2);
+      }
+
+      simplex.initColumnPool(pool_age);
+
+      double negeps = std::nextafter(-opt_tolerance, -0.0);
+      Vars vars;
+      Vars vnew;
+
+      // Seed the columns from the coarser level, and the spanning forest of
+      // the first basis from the lifted flow
+      std::vector<int> tree;
+      if (k + 1 < int(P.size())) {
+        const PointCloud2D &Cs = P[k + 1];
+        const std::vector<int> &U = up[k];
+
+        // Directions of the coarse flow out of every coarse node
+        std::vector<std::vector<std::pair<int, int>>> dirs(Cs.size());
+        for (const auto &e : support)
+          dirs[e.a].emplace_back(Cs.getX(e.b) - Cs.getX(e.a),
+                                 Cs.getY(e.b) - Cs.getY(e.a));
+
+        // A coarse arc is two fine arcs in the same direction
+        std::unordered_set<uint64_t> seen;
+        auto seed = [&](int x, int y, int v, int w) {
+          int a = x + v;
+          int b = y + w;
+          if (a < 0 || a >= xmax || b < 0 || b >= ymax || G[ID(a, b)] < 0)
+            return;
+          int h = G[ID(x, y)];
+          int j = G[ID(a, b)];
+          if (seen.insert(uint64_t(h) << 32 | uint64_t(j)).second)
+            vnew.emplace_back(h, j, std::sqrt(double(v * v + w * w)));
+        };
+        for (int i = 0; i < n; ++i) {
+          int x = Ls.getX(i);
+          int y = Ls.getY(i);
+          for (const auto &d : dirs[U[i]]) {
+            seed(x, y, d.first, d.second);
+            int a = x + d.first;
+            int b = y + d.second;
+            if (a >= 0 && a < xmax && b >= 0 && b < ymax && G[ID(a, b)] >= 0)
+              seed(a, b, d.first, d.second);
+          }
+        }
+
+        size_t n_lifted = vnew.size();
+
+        // Arcs priced out by the lifted potentials
+        vector<double> lift(n);
+        for (int i = 0; i < n; ++i)
+          lift[i] = 2 * pi[U[i]];
+        Vars vsep;
+        separateColumns(Ls, xmax, ymax, G, lift, negeps, vars, vsep);
+        for (const auto &v : vsep)
+          if (seen.insert(uint64_t(v.a) << 32 | uint64_t(v.b)).second)
+            vnew.push_back(v);
+
+        std::vector<int> ids;
+        simplex.addColumns(vnew, &ids);
+        tree.assign(ids.begin(), ids.begin() + n_lifted);
+      }
+
+      if (_n_log > 0)
+        PRINT("INFO: multiscale level %d, V=%d, seed E=%ld\n", k, n,
+              simplex.num_arcs());
+
+      // Column generation at this level
+      if (tree.empty())
+        simplex.run(pivotRule());
+      else
+        simplex.seedRun(tree, pivotRule());
+      pi.assign(n, 0);
+      while (true) {
+        _status = simplex.reRun(pivotRule());
+        if (_status == ProblemType::TIMELIMIT ||
+            _status == ProblemType::CANCELLED)
+          break;
+
+        for (int j = 0; j < n; ++j)
+          pi[j] = -simplex.potential(j);
+
+        separateColumns(Ls, xmax, ymax, G, pi, negeps, vars, vnew);
+        if (vnew.empty())
+          break;
+
+        simplex.addColumns(vnew);
+      }
+
+      _iterations += simplex.iterations();
+      _stats += simplex.stats();
+
+      if (_status == ProblemType::TIMELIMIT ||
+          _status == ProblemType::CANCELLED)
+        return std::numeric_limits<CostType>::max();
+
+      if (k == 0) {
+        _pool_stats = simplex.poolStats();
+        _num_arcs = simplex.num_arcs();
+        _num_nodes = simplex.num_nodes();
+        _runtime =
+            double(std::chrono::duration_cast<std::chrono::milliseconds>(
+                       std::chrono::steady_clock::now() - start_t)
+                       .count()) /
+            1000;
+        return simplex.totalCost();
+      }
+
+      // Keep the support of the flow for the next level, without the arcs
+      // of the unbalanced node
+      support.clear();
+      for (const auto &e : simplex.flowSupport())
+        if (e.a < n && e.b < n)
+          support.push_back(e);
+    }
+
+    return std::numeric_limits<CostType>::max();
+  }
+
+  // Optimality tolerance for the cost type: single precision costs carry a
+  // rounding error of half an ulp of the largest cost
+  template <typename CostType> double optTolerance() const {
+    double c_max = 0.0;
+    for (const auto &p : coprimes)
+      c_max = std::max(c_max, p.c_vw);
+    return std::max(opt_tolerance,
+                    8 * double(std::numeric_limits<CostType>::epsilon()) *
+                        c_max);
+  }
+
+  // Solve the L-approximation model of Rs with the cost scaling algorithm,
+  // with supplies and costs scaled to integers as in integer precision
+  double solveCostScaling(const PointCloud2D &Rs, int xmin, int ymin,
+                          int xmax, int ymax, double tot_w1, double tot_w2) {
+    int n = static_cast<int>(Rs.size());
+
+    std::vector<double> B(n + int(unbalanced == true));
+    for (int i = 0; i < n; ++i)
+      B[i] = Rs.getB(i);
+    if (unbalanced)
+      B[n] = -Rs.balance();
+
+    double mass_scale = 1.0;
+    std::vector<int64_t> Q = scaleSupplies<int64_t>(B, mass_scale);
+    double cost_scale =
+        std::floor(CostScaling<>::maxCost(int(B.size())) / maxArcCost());
+
+    CostScaling<> flow(int(B.size()), n * static_cast<int>(coprimes.size()));
+    flow.setTimelimit(timelimit);
+    flow.setCancelToken(cancel_token);
+    flow.setVerbosity(verbosity);
+
+    for (int i = 0; i < int(B.size()); ++i)
+      flow.addNode(i, Q[i]);
+    addGridArcs(flow, Rs, xmin, ymin, xmax, ymax, cost_scale);
+
+    if (unbalanced) {
+      double bb = B[n];
+      int64_t c1 = scaleCost<int64_t>(bb < 0 ? unbal_cost : 0, cost_scale);
+      int64_t c2 = scaleCost<int64_t>(bb < 0 ? 0 : unbal_cost, cost_scale);
+      for (int i = 0; i < n; ++i)
+        flow.addArc(i, n, c1);
+      for (int i = 0; i < n; ++i)
+        flow.addArc(n, i, c2);
+    }
+
+    if (verbosity == KWD_VAL_INFO)
+      PRINT("INFO: running CostScaling with V=%ld and E=%ld\n",
+            flow.num_nodes(), flow.num_arcs());
+    _status = flow.run();
+
+    _runtime = flow.runtime();
+    _iterations = flow.iterations();
+    _stats = SimplexStats();
+    _num_arcs = flow.num_arcs();
+    _num_nodes = flow.num_nodes();
+
+    double distance = std::numeric_limits<double>::max();
+
+    if (_status != ProblemType::INFEASIBLE &&
+        _status != ProblemType::UNBOUNDED &&
+        _status != ProblemType::TIMELIMIT &&
+        _status != ProblemType::CANCELLED)
+      distance = flow.totalCost<double>() / (mass_scale * cost_scale);
+
+    _error_bound =
+        errorBound<int64_t>(n, xmin, ymin, xmax, ymax, mass_scale, cost_scale);
+
+    if (unbalanced) {
+      distance = distance / std::max(tot_w1, tot_w2);
+      _error_bound = _error_bound / std::max(tot_w1, tot_w2);
+    }
+
+    return distance;
+  }
+
+  // Solve the L-approximation model of Rs with the cost scaling algorithm
+  // for the m supply vectors set by supplies(k, B), where B[n] is the supply
+  // of the unbalanced node. The network is built once for all the supply
+  // vectors. Ds and Es get the distances and the error bounds, not divided
+  // by the total mass
+  template <typename Supplies>
+  void solveCostScaling(const PointCloud2D &Rs, int xmin, int ymin, int xmax,
+                        int ymax, int m, Supplies supplies, vector<double> &Ds,
+                        vector<double> &Es) {
+    int n = static_cast<int>(Rs.size());
+    int nn = n + int(unbalanced == true);
+
+    double cost_scale = std::floor(CostScaling<>::maxCost(nn) / maxArcCost());
+
+    CostScaling<> flow(nn, n * static_cast<int>(coprimes.size()));
+    flow.setTimelimit(timelimit);
+    flow.setCancelToken(cancel_token);
+    flow.setVerbosity(verbosity);
+
+    addGridArcs(flow, Rs, xmin, ymin, xmax, ymax, cost_scale);
+
+    vector<size_t> lhs_arcs(n, 0);
+    vector<size_t> rhs_arcs(n, 0);
+    if (unbalanced) {
+      for (int i = 0; i < n; ++i)
+        lhs_arcs[i] = flow.addArc(i, n, 0);
+      for (int i = 0; i < n; ++i)
+        rhs_arcs[i] = flow.addArc(n, i, 0);
+    }
+
+    _num_arcs = flow.num_arcs();
+    _num_nodes = flow.num_nodes();
+    _stats = SimplexStats();
+
+    if (verbosity == KWD_VAL_INFO)
+      PRINT("INFO: running CostScaling with V=%ld and E=%ld\n",
+            flow.num_nodes(), flow.num_arcs());
+
+    std::vector<double> B(nn);
+
+    for (int k = 0; k < m; ++k) {
+      supplies(k, B);
+
+      double mass_scale = 1.0;
+      std::vector<int64_t> Q = scaleSupplies<int64_t>(B, mass_scale);
+      for (int i = 0; i < nn; ++i)
+        flow.addNode(i, Q[i]);
+
+      if (unbalanced) {
+        double bb = B[n];
+        int64_t c1 = scaleCost<int64_t>(bb < 0 ? unbal_cost : 0, cost_scale);
+        int64_t c2 = scaleCost<int64_t>(bb < 0 ? 0 : unbal_cost, cost_scale);
+        for (int i = 0; i < n; ++i)
+          flow.setArcCost(lhs_arcs[i], c1);
+        for (int i = 0; i < n; ++i)
+          flow.setArcCost(rhs_arcs[i], c2);
+      }
+
+      _status = flow.run();
+
+      _runtime += flow.runtime();
+      _iterations += flow.iterations();
+
+      Ds[k] = std::numeric_limits<double>::max();
+      Es[k] = 0.0;
+
+      if (_status != ProblemType::INFEASIBLE &&
+          _status != ProblemType::UNBOUNDED &&
+          _status != ProblemType::TIMELIMIT &&
+          _status != ProblemType::CANCELLED) {
+        Ds[k] = flow.totalCost<double>() / (mass_scale * cost_scale);
+        Es[k] = errorBound<int64_t>(n, xmin, ymin, xmax, ymax, mass_scale,
+                                    cost_scale);
+      } else
+        PRINT("ERROR 1001: CostScaling wrong. Error code: %d\n",
+              (int)_status);
+    }
+  }
+
+  // Add to the network the arcs of the L-approximation graph of Rs, with
+  // costs scaled to the cost type of the network
+  template <typename S>
+  void addGridArcs(S &flow, const PointCloud2D &Rs, int xmin, int ymin,
+                   int xmax, int ymax, double cost_scale) const {
+    int n = static_cast<int>(Rs.size());
+
+    // Binary vector for positions
+    auto ID = [&ymax](int x, int y) { return x * ymax + y; };
+
+    std::vector<int> H(size_t(xmax) * size_t(ymax), -1);
+    for (int i = 0; i < n; ++i)
+      H[ID(Rs.getX(i), Rs.getY(i))] = i;
+
+    for (int h = 0; h < n; ++h) {
+      int i = Rs.getX(h);
+      int j = Rs.getY(h);
+      for (const auto &p : coprimes) {
+        int v = p.v;
+        int w = p.w;
+        if (i + v >= xmin && i + v < xmax && j + w >= ymin && j + w < ymax &&
+            H[ID(i + v, j + w)] >= 0)
+          flow.addArc(h, H[ID(i + v, j + w)],
+                      scaleCost<typename S::Cost>(p.c_vw, cost_scale));
+      }
+    }
+  }
+
+  // Largest cost of an arc of the network models, with or without the
+  // costs of the arcs of the unbalanced node
+  double maxArcCost(bool unbal_arcs = true) const {
+    double c_max = 1.0;
+    for (const auto &p : coprimes)
+      c_max = std::max(c_max, p.c_vw);
+    if (unbalanced && unbal_arcs)
+      c_max = std::max(c_max, unbal_cost);
+    return c_max;
+  }
+
+  // Supplies B in the flow type. Integer types get the positive supplies
+  // scaled to KWD_INTEGER_MASS units, and rounded down except for the
+  // largest remainders, so that the supplies still sum up to zero
+  template <typename FlowType>
+  std::vector<FlowType> scaleSupplies(const std::vector<double> &B,
+                                      double &scale) const {
+    size_t n = B.size();
+    std::vector<FlowType> Q(n);
+    scale = 1.0;
+    if (!std::numeric_limits<FlowType>::is_exact) {
+      for (size_t i = 0; i < n; ++i)
+        Q[i] = FlowType(B[i]);
+      return Q;
+    }
+
+    double pos = 0.0;
+    for (double b : B)
+      if (b > 0)
+        pos += b;
+    if (pos > 0)
+      scale = double(KWD_INTEGER_MASS) / pos;
+
+    std::vector<std::pair<double, size_t>> R(n);
+    int64_t tot = 0;
+    for (size_t i = 0; i < n; ++i) {
+      double s = B[i] * scale;
+      double f = std::floor(s);
+      Q[i] = FlowType(f);
+      tot += int64_t(Q[i]);
+      R[i] = {s - f, i};
+    }
+
+    // Round up the -tot largest remainders (ties by index)
+    size_t r = size_t(std::min(std::max(-tot, int64_t(0)), int64_t(n)));
+    if (r > 0) {
+      auto larger = [](const std::pair<double, size_t> &a,
+                       const std::pair<double, size_t> &b) {
+        return a.first > b.first || (a.first == b.first && a.second < b.second);
+      };
+      std::nth_element(R.begin(), R.begin() + (r - 1), R.end(), larger);
+      for (size_t k = 0; k < r; ++k)
+        Q[R[k].second] += 1;
+    }
+
+    return Q;
+  }
+
+  // Scale of the costs for the cost type. Integer costs use the largest
+  // scale that keeps the potentials of the network simplex, which start at
+  // half of the range of the type, far from overflow
+  template <typename CostType>
+  double costScale(int n, bool unbal_arcs = true) const {
+    if (!std::numeric_limits<CostType>::is_exact)
+      return 1.0;
+
+    return std::floor(double((std::numeric_limits<CostType>::max)()) /
+                      (8.0 * (double(n) + 2.0) * maxArcCost(unbal_arcs)));
+  }
+
+  // Cost c in the cost type, scaled and rounded for integer types
+  template <typename CostType>
+  CostType scaleCost(double c, double scale) const {
+    if (std::numeric_limits<CostType>::is_exact)
+      return CostType(std::llround(c * scale));
+    return CostType(c);
+  }
+
+  // Bound on the rounding error of a distance computed with the given
+  // scales: every supply is off by less than one unit and every cost by
+  // half a unit, while a unit of flow moves at most along the L1 diameter
+  // of the grid using arcs of cost at least one
+  template <typename CostType>
+  double errorBound(int n, int xmin, int ymin, int xmax, int ymax,
+                    double mass_scale, double cost_scale) const {
+    if (!std::numeric_limits<CostType>::is_exact)
+      return 0.0;
+
+    double D = double(xmax - xmin) + double(ymax - ymin);
+    return D / mass_scale *
+           (double(n) + 1.0 + double(KWD_INTEGER_MASS) / cost_scale);
+  }
+
+  // Place the nodes of Rs on the grid and add an arc direction for every
+  // coprime pair: the network is shared by all the solvers on Rs
+  template <typename C>
+  std::shared_ptr<const GridNetwork<C>>
+  gridNetwork(const PointCloud2D &Rs, int xmax, int ymax) const {
+    int n = static_cast<int>(Rs.size());
+    auto net = std::make_shared<GridNetwork<C>>(n, xmax, ymax, L);
+    for (int i = 0; i < n; ++i)
+      net->setNode(i, Rs.getX(i), Rs.getY(i));
+    for (const auto &p : coprimes)
+      net->addDirection(p.v, p.w, p.c_vw);
+    return net;
+  }
+
+  // The solver on a grid network prices with the block search in double
+  // precision: warn if the parameters ask for something else
+  void checkImplicitArcs() const {
+    if (pivot_rule != KWD_VAL_BLOCKSEARCH)
+      PRINT("WARNING: PivotRule=%s is ignored with ImplicitArcs: the block "
+            "search is used.\n",
+            pivot_rule.c_str());
+    if (precision != KWD_VAL_DOUBLE)
+      PRINT("WARNING: Precision=%s is ignored with ImplicitArcs: the double "
+            "precision is used.\n",
+            precision.c_str());
+  }
+
+  // Arcs of the L-approximation graph of Rs, with costs scaled to the cost
+  // type, built once for the network simplex solvers of a batch
+  template <typename C>
+  std::shared_ptr<const ArcList<C>> gridArcs(const PointCloud2D &Rs, int xmin,
+                                             int ymin, int xmax, int ymax,
+                                             double cost_scale) const {
+    auto arcs = std::make_shared<ArcList<C>>();
+    addGridArcs(*arcs, Rs, xmin, ymin, xmax, ymax, cost_scale);
+    return arcs;
+  }
+
+  // Set the parameters of a solver on a grid network
+  template <typename S> void setupGridSolver(S &simplex) const {
+    simplex.setTimelimit(timelimit);
+    simplex.setCancelToken(cancel_token);
+    simplex.setVerbosity(verbosity);
+    simplex.setOptTolerance(opt_tolerance);
+  }
+
+  // Set the parameters of the solver of a batch worker without logging,
+  // since PRINT must not be called out of the main thread (Rprintf in R):
+  // with several workers the solver is also silent
+  template <typename S>
+  void setupBatchSolver(S &simplex, int workers) const {
+    simplex.setParams(timelimit, cancel_token,
+                      workers > 1 ? std::string(KWD_VAL_SILENT) : verbosity,
+                      opt_tolerance);
+  }
+
+  // The network simplex of a batch worker prices on one thread when there
+  // are several workers
+  template <typename F, typename C>
+  void setupBatchSolver(NetSimplex<F, C> &simplex, int workers) const {
+    setupBatchSolver(simplex, workers, opt_tolerance);
+  }
+
+  template <typename F, typename C>
+  void setupBatchSolver(NetSimplex<F, C> &simplex, int workers,
+                        double tol) const {
+    simplex.setParams(timelimit, cancel_token,
+                      workers > 1 ? std::string(KWD_VAL_SILENT) : verbosity,
+                      tol, workers > 1 ? 1 : threads);
+  }
+
+  // Log the targets of a batch whose network simplex failed, after the
+  // parallel region
+  void logBatchErrors(const std::vector<ProblemType> &sts) const {
+    for (auto st : sts)
+      if (st == ProblemType::INFEASIBLE || st == ProblemType::UNBOUNDED ||
+          st == ProblemType::TIMELIMIT || st == ProblemType::CANCELLED)
+        PRINT("ERROR 1001: Network Simplex wrong. Error code: %d\n", (int)st);
+  }
+
+  // Merge two historgram into a PointCloud
+  PointCloud2D mergeHistograms(const Histogram2D &A, const Histogram2D &B) {
+    int xmin = std::numeric_limits<int>::max();
+    int ymin = std::numeric_limits<int>::max();
+    for (const auto &p : A) {
+      xmin = std::min(xmin, p.first.first);
+      ymin = std::min(ymin, p.first.second);
+    }
+    for (const auto &p : B) {
+      xmin = std::min(xmin, p.first.first);
+      ymin = std::min(ymin, p.first.second);
+    }
+
+    PointCloud2D Rs;
 
     // Read first line
     for (const auto &k : A)
@@ -2927,6 +4506,15 @@ private:
   uint64_t _num_nodes;
   uint64_t _num_arcs;
 
+  // Bound on the rounding error of integer precision
+  double _error_bound;
+
+  // Pivot statistics of the network simplex
+  SimplexStats _stats;
+
+  // Statistics of the column pool of the column generation
+  ColumnPoolStats _pool_stats;
+
   // Interval for logging iterations in the simplex algorithm
   // (if _n_log=0 no logs at all)
   int _n_log;
@@ -2935,7 +4523,7 @@ private:
   int L;
 
   // List of pair of coprimes number between (-L, L)
-  std::vector<coprimes_t> coprimes;
+  CoprimeTable coprimes;
 
   // Method to solve the problem
   std::string method;
@@ -2951,12 +4539,44 @@ private:
   double opt_tolerance;
   // Time limit for runtime of the algorithm
   double timelimit;
+  // Number of threads for pricing inside the network simplex
+  int threads;
+  // Number of threads over the targets of a batch comparison
+  int batch_threads;
   // If the problem must be considered unbalanced
   bool unbalanced;
   // Cost for the unbalanced connection
   double unbal_cost;
+  // Capacities instead of big-M costs on the arcs of the unbalanced node
+  bool capacitated;
+  // Columns per node and eviction age of the column generation pool
+  int pool_columns;
+  int pool_age;
   // Whether to compute the convex hull
   bool convex_hull;
+  // Reuse the basis of the previous solve in batched comparisons
+  std::string warm_start;
+  // Pivot rule of the network simplex
+  std::string pivot_rule;
+  // Use the network simplex with implicit arcs on the grid
+  bool implicit_arcs;
+  // Number type of flows and costs (double, single, integer)
+  std::string precision;
+  // Numbering of the nodes (input, morton, hilbert)
+  std::string node_order;
+
+  // Cancel token of the solves
+  const CancelToken *cancel_token;
+
+  // Network simplex instances kept across calls, by number types and
+  // thread (a copy of the solver starts with an empty pool)
+  struct SimplexPool {
+    SimplexPool() {}
+    SimplexPool(const SimplexPool &) {}
+    SimplexPool &operator=(const SimplexPool &) { return *this; }
+
+    std::map<std::pair<std::type_index, int>, std::shared_ptr<void>> slots;
+  } _pool;
 
 }; // namespace KWD
 
@@ -35,13 +35,123 @@
 #define PRINT printf
 #endif // MY_RCPP
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cstring>
 #include <exception>
 #include <limits>
+#include <memory>
+#include <type_traits>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#ifdef KWD_PROFILE
+// Run the statement s and add its runtime in seconds to t
+#define KWD_PROFILE_PHASE(t, s)                                                \
+  {                                                                            \
+    auto kwd_start_t = std::chrono::steady_clock::now();                       \
+    s;                                                                         \
+    t += std::chrono::duration<double>(std::chrono::steady_clock::now() -      \
+                                       kwd_start_t)                            \
+             .count();                                                         \
+  }
+// Add v to the counter x
+#define KWD_PROFILE_ADD(x, v) (x) += (v)
+#else
+#define KWD_PROFILE_PHASE(t, s) s
+#define KWD_PROFILE_ADD(x, v)
+#endif
 
 namespace KWD {
 const double FEASIBILITY_TOL = 1e-09;
 const double PRIC_TOL = 1e-09;
+// Pivots between two checks of the deadline and of the cancel token
+const uint64_t CHECK_INTERVAL = 64;
+
+// Pivot statistics of the network simplex, collected only when compiled
+// with -DKWD_PROFILE (otherwise they stay zero). Times are in seconds
+struct SimplexStats {
+  uint64_t pivots;
+  uint64_t degenerate_pivots;
+
+  // Time spent in every phase of a pivot
+  double t_enter, t_join, t_leave, t_flow, t_tree, t_potential;
+
+  // Nodes visited by the tree walks: cycle of the entering arc, stem of
+  // the tree update, and subtree with updated potentials
+  uint64_t cycle_nodes, stem_nodes, subtree_nodes;
+
+  SimplexStats()
+      : pivots(0), degenerate_pivots(0), t_enter(0), t_join(0), t_leave(0),
+        t_flow(0), t_tree(0), t_potential(0), cycle_nodes(0), stem_nodes(0),
+        subtree_nodes(0) {}
+
+  SimplexStats &operator+=(const SimplexStats &o) {
+    pivots += o.pivots;
+    degenerate_pivots += o.degenerate_pivots;
+    t_enter += o.t_enter;
+    t_join += o.t_join;
+    t_leave += o.t_leave;
+    t_flow += o.t_flow;
+    t_tree += o.t_tree;
+    t_potential += o.t_potential;
+    cycle_nodes += o.cycle_nodes;
+    stem_nodes += o.stem_nodes;
+    subtree_nodes += o.subtree_nodes;
+    return *this;
+  }
+
+  // Average length of the tree walks per pivot
+  double avgCycle() const { return pivots ? double(cycle_nodes) / pivots : 0; }
+  double avgStem() const { return pivots ? double(stem_nodes) / pivots : 0; }
+  double avgSubtree() const {
+    return pivots ? double(subtree_nodes) / pivots : 0;
+  }
+
+  void dump() const {
+    PRINT("Pivots: %lu (degenerate %lu) | enter: %.3f, join: %.3f, leave: "
+          "%.3f, flow: %.3f, tree: %.3f, potential: %.3f | avg cycle: %.1f, "
+          "stem: %.1f, subtree: %.1f\n",
+          (unsigned long)pivots, (unsigned long)degenerate_pivots, t_enter,
+          t_join, t_leave, t_flow, t_tree, t_potential, avgCycle(), avgStem(),
+          avgSubtree());
+  }
+};
+
+// Statistics of the column pool of the column generation
+struct ColumnPoolStats {
+  // Rounds of new columns, columns stored in new arcs and columns stored in
+  // the arc of an evicted column
+  uint64_t rounds, appended, replaced;
+  // Columns in the pool, and evictable columns found by the last round
+  uint64_t size, evictable;
+
+  ColumnPoolStats()
+      : rounds(0), appended(0), replaced(0), size(0), evictable(0) {}
+
+  ColumnPoolStats &operator+=(const ColumnPoolStats &o) {
+    rounds += o.rounds;
+    appended += o.appended;
+    replaced += o.replaced;
+    size = (std::max)(size, o.size);
+    evictable = o.evictable;
+    return *this;
+  }
+
+  void dump() const {
+    PRINT("Column pool: %lu rounds, %lu columns (%lu appended, %lu replaced, "
+          "%lu evictable)\n",
+          (unsigned long)rounds, (unsigned long)size, (unsigned long)appended,
+          (unsigned long)replaced, (unsigned long)evictable);
+  }
+};
 
 template <typename V = int, typename C = V> class GVar {
 public:
@@ -57,14 +167,348 @@ public:
 typedef GVar<int, double> Var;
 typedef std::vector<Var> Vars;
 
+// Arcs of a network, built once and shared read only by the network
+// simplex solvers of a batch (see NetSimplex::addArcs)
+template <typename C> struct ArcList {
+  typedef C Cost;
+
+  std::vector<int> source;
+  std::vector<int> target;
+  std::vector<C> cost;
+
+  size_t addArc(int a, int b, C c) {
+    source.push_back(a);
+    target.push_back(b);
+    cost.push_back(c);
+    return source.size() - 1;
+  }
+
+  size_t num_arcs() const { return source.size(); }
+};
+
 enum class ProblemType {
   INFEASIBLE = 0,
   OPTIMAL = 1,
   UNBOUNDED = 2,
-  TIMELIMIT = 3
+  TIMELIMIT = 3,
+  CANCELLED = 4
+};
+
+// Flag to stop a running solve from another thread: the network simplex
+// checks it every CHECK_INTERVAL pivots
+class CancelToken {
+public:
+  CancelToken() : _cancelled(false) {}
+
+  void cancel() { _cancelled.store(true, std::memory_order_relaxed); }
+  void reset() { _cancelled.store(false, std::memory_order_relaxed); }
+  bool cancelled() const { return _cancelled.load(std::memory_order_relaxed); }
+
+private:
+  std::atomic<bool> _cancelled;
+};
+
+// Point in time t seconds from now (never, for huge t)
+inline std::chrono::steady_clock::time_point deadlineAfter(double t) {
+  if (!(t < 1e9))
+    return (std::chrono::steady_clock::time_point::max)();
+  return std::chrono::steady_clock::now() +
+         std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+             std::chrono::duration<double>(t));
+}
+
+enum class PivotRule {
+  BLOCK_SEARCH = 0,
+  CANDIDATE_LIST = 1,
+  ALTERING_LIST = 2,
+  ADAPTIVE_BLOCK_SEARCH = 3
+};
+
+// Pricing kernel of the pivot rules: scan the arcs in [begin, end) and keep
+// in (min, arc) the first arc with the most negative reduced cost smaller
+// than min. Arcs with state 0 (in the basis) are skipped.
+template <typename C, typename P>
+inline void priceArcs(int begin, int end, const int *source, const int *target,
+                      const C *cost, const signed char *state, const P *pi,
+                      P &min, int &arc) {
+  for (int e = begin; e < end; ++e) {
+    P c = state[e] * (cost[e] + pi[source[e]] - pi[target[e]]);
+    if (c < min) {
+      min = c;
+      arc = e;
+    }
+  }
+}
+
+// Pricing kernel on arcs stored as records with the fields source, target,
+// cost and state
+template <typename A, typename P>
+inline void priceArcs(int begin, int end, const A *arcs, const P *pi, P &min,
+                      int &arc) {
+  for (int e = begin; e < end; ++e) {
+    const A &a = arcs[e];
+    P c = a.state * (a.cost + pi[a.source] - pi[a.target]);
+    if (c < min) {
+      min = c;
+      arc = e;
+    }
+  }
+}
+
+#if defined(__AVX512F__)
+// Lanes of the vectorized pricing kernel: the reduced costs of 8 arcs, in
+// double for floating point costs and in int64 for integer costs. Only
+// AVX-512F instructions are used, and the arc indices take 64 bit lanes.
+// The potentials are gathered for the non basic arcs only
+template <typename C> struct PriceLanes;
+
+template <> struct PriceLanes<double> {
+  static const int W = 8;
+  typedef double Value;
+  typedef __m512d Vec;
+  typedef __mmask8 Mask;
+
+  static Mask live(const signed char *state) {
+    __m512i st = _mm512_maskz_cvtepi8_epi64(
+        0xFF, _mm_loadl_epi64(reinterpret_cast<const __m128i *>(state)));
+    return _mm512_test_epi64_mask(st, st);
+  }
+  static Vec set1(double v) { return _mm512_set1_pd(v); }
+  static Vec cost(const double *c) { return _mm512_loadu_pd(c); }
+  static Vec gather(Mask live, const int *idx, const double *pi) {
+    return _mm512_mask_i32gather_pd(
+        _mm512_setzero_pd(), live,
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(idx)), pi, 8);
+  }
+  static Vec add(Vec a, Vec b) { return _mm512_add_pd(a, b); }
+  static Vec sub(Vec a, Vec b) { return _mm512_sub_pd(a, b); }
+  static Mask less(Mask live, Vec a, Vec b) {
+    return _mm512_mask_cmp_pd_mask(live, a, b, _CMP_LT_OQ);
+  }
+  static Vec select(Vec a, Mask m, Vec b) { return _mm512_mask_mov_pd(a, m, b); }
+  static void store(double *p, Vec v) { _mm512_storeu_pd(p, v); }
+
+  typedef __m512i Index;
+  static Index index(int begin) {
+    return _mm512_add_epi64(_mm512_set1_epi64(begin),
+                            _mm512_set_epi64(7, 6, 5, 4, 3, 2, 1, 0));
+  }
+  static Index none() { return _mm512_set1_epi64(-1); }
+  static Index step(Index i) { return _mm512_add_epi64(i, _mm512_set1_epi64(W)); }
+  static Index select(Index a, Mask m, Index b) {
+    return _mm512_mask_mov_epi64(a, m, b);
+  }
+  static void store(int64_t *p, Index v) { _mm512_storeu_si512(p, v); }
+};
+
+// Single precision costs are widened to the double lanes, with half of the
+// cost bandwidth
+template <> struct PriceLanes<float> : PriceLanes<double> {
+  static Vec cost(const float *c) {
+    return _mm512_maskz_cvtps_pd(0xFF, _mm256_loadu_ps(c));
+  }
+};
+
+template <> struct PriceLanes<int64_t> {
+  static const int W = 8;
+  typedef int64_t Value;
+  typedef __m512i Vec;
+  typedef __mmask8 Mask;
+
+  static Mask live(const signed char *state) {
+    return PriceLanes<double>::live(state);
+  }
+  static Vec set1(int64_t v) { return _mm512_set1_epi64(v); }
+  static Vec cost(const int64_t *c) { return _mm512_loadu_si512(c); }
+  static Vec gather(Mask live, const int *idx, const int64_t *pi) {
+    return _mm512_mask_i32gather_epi64(
+        _mm512_setzero_si512(), live,
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(idx)), pi, 8);
+  }
+  static Vec add(Vec a, Vec b) { return _mm512_add_epi64(a, b); }
+  static Vec sub(Vec a, Vec b) { return _mm512_sub_epi64(a, b); }
+  static Mask less(Mask live, Vec a, Vec b) {
+    return _mm512_mask_cmplt_epi64_mask(live, a, b);
+  }
+  static Vec select(Vec a, Mask m, Vec b) {
+    return _mm512_mask_mov_epi64(a, m, b);
+  }
+  static void store(int64_t *p, Vec v) { _mm512_storeu_si512(p, v); }
+
+  typedef __m512i Index;
+  static Index none() { return PriceLanes<double>::none(); }
+  static Index index(int begin) { return PriceLanes<double>::index(begin); }
+  static Index step(Index i) { return PriceLanes<double>::step(i); }
+};
+#elif defined(__AVX2__)
+// Lanes of the vectorized pricing kernel: the reduced costs of 4 arcs, in
+// double for floating point costs and in int64 for integer costs
+template <typename C> struct PriceLanes;
+
+template <> struct PriceLanes<double> {
+  static const int W = 4;
+  typedef double Value;
+  typedef __m256d Vec;
+  typedef __m256d Mask;
+
+  static Mask live(const signed char *state) {
+    int32_t sw;
+    std::memcpy(&sw, state, sizeof(sw));
+    __m256i st = _mm256_cvtepi8_epi64(_mm_cvtsi32_si128(sw));
+    return _mm256_castsi256_pd(
+        _mm256_cmpgt_epi64(st, _mm256_setzero_si256()));
+  }
+  static Vec set1(double v) { return _mm256_set1_pd(v); }
+  static Vec cost(const double *c) { return _mm256_loadu_pd(c); }
+  static Vec gather(Mask live, const int *idx, const double *pi) {
+    return _mm256_mask_i32gather_pd(
+        _mm256_setzero_pd(), pi,
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(idx)), live, 8);
+  }
+  static Vec add(Vec a, Vec b) { return _mm256_add_pd(a, b); }
+  static Vec sub(Vec a, Vec b) { return _mm256_sub_pd(a, b); }
+  static Mask less(Mask live, Vec a, Vec b) {
+    return _mm256_and_pd(live, _mm256_cmp_pd(a, b, _CMP_LT_OQ));
+  }
+  static Vec select(Vec a, Mask m, Vec b) { return _mm256_blendv_pd(a, b, m); }
+  static void store(double *p, Vec v) { _mm256_storeu_pd(p, v); }
+
+  typedef __m256i Index;
+  static Index index(int begin) {
+    return _mm256_add_epi64(_mm256_set1_epi64x(begin),
+                            _mm256_setr_epi64x(0, 1, 2, 3));
+  }
+  static Index none() { return _mm256_set1_epi64x(-1); }
+  static Index step(Index i) {
+    return _mm256_add_epi64(i, _mm256_set1_epi64x(W));
+  }
+  static Index select(Index a, Mask m, Index b) {
+    return _mm256_castpd_si256(_mm256_blendv_pd(
+        _mm256_castsi256_pd(a), _mm256_castsi256_pd(b), m));
+  }
+  static void store(int64_t *p, Index v) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), v);
+  }
+};
+
+// Single precision costs are widened to the double lanes, with half of the
+// cost bandwidth
+template <> struct PriceLanes<float> : PriceLanes<double> {
+  static Vec cost(const float *c) { return _mm256_cvtps_pd(_mm_loadu_ps(c)); }
 };
 
-enum class PivotRule { BLOCK_SEARCH = 0 };
+template <> struct PriceLanes<int64_t> {
+  static const int W = 4;
+  typedef int64_t Value;
+  typedef __m256i Vec;
+  typedef __m256i Mask;
+
+  static Mask live(const signed char *state) {
+    return _mm256_castpd_si256(PriceLanes<double>::live(state));
+  }
+  static Vec set1(int64_t v) { return _mm256_set1_epi64x(v); }
+  static Vec cost(const int64_t *c) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(c));
+  }
+  static Vec gather(Mask live, const int *idx, const int64_t *pi) {
+    return _mm256_mask_i32gather_epi64(
+        _mm256_setzero_si256(), reinterpret_cast<const long long *>(pi),
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(idx)), live, 8);
+  }
+  static Vec add(Vec a, Vec b) { return _mm256_add_epi64(a, b); }
+  static Vec sub(Vec a, Vec b) { return _mm256_sub_epi64(a, b); }
+  static Mask less(Mask live, Vec a, Vec b) {
+    return _mm256_and_si256(live, _mm256_cmpgt_epi64(b, a));
+  }
+  static Vec select(Vec a, Mask m, Vec b) { return _mm256_blendv_epi8(a, b, m); }
+  static void store(int64_t *p, Vec v) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), v);
+  }
+
+  typedef __m256i Index;
+  static Index none() { return PriceLanes<double>::none(); }
+  static Index index(int begin) { return PriceLanes<double>::index(begin); }
+  static Index step(Index i) { return PriceLanes<double>::step(i); }
+};
+#endif
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+// Vectorized pricing of the arcs in [begin, end): every lane keeps its own
+// minimum, and lane ties are broken on the smallest arc index, so the
+// selected arc is the same of the scalar loop. Return the first arc left
+// to the scalar loop
+template <typename C>
+inline int priceLanes(int begin, int end, const int *source, const int *target,
+                      const C *cost, const signed char *state,
+                      const typename PriceLanes<C>::Value *pi,
+                      typename PriceLanes<C>::Value &min, int &arc) {
+  typedef PriceLanes<C> L;
+  const int W = L::W;
+  if (end - begin < 2 * W)
+    return begin;
+
+  typename L::Vec vmin = L::set1(min);
+  typename L::Index vbest = L::none();
+  typename L::Index vcur = L::index(begin);
+  int e = begin;
+  for (; e + W <= end; e += W) {
+    typename L::Mask live = L::live(state + e);
+    typename L::Vec c = L::add(L::cost(cost + e), L::gather(live, source + e, pi));
+    c = L::sub(c, L::gather(live, target + e, pi));
+    typename L::Mask m = L::less(live, c, vmin);
+    vmin = L::select(vmin, m, c);
+    vbest = L::select(vbest, m, vcur);
+    vcur = L::step(vcur);
+  }
+
+  typename L::Value lmin[W];
+  int64_t lbest[W];
+  L::store(lmin, vmin);
+  L::store(lbest, vbest);
+  int best = 0;
+  for (int l = 1; l < W; ++l)
+    if (lmin[l] < lmin[best] ||
+        (lmin[l] == lmin[best] && lbest[l] < lbest[best]))
+      best = l;
+  if (lmin[best] < min) {
+    min = lmin[best];
+    arc = static_cast<int>(lbest[best]);
+  }
+  return e;
+}
+#endif
+
+// Vectorized kernels for double, single precision and integer costs: the
+// lanes price the bulk of the range, and the scalar loop the rest
+inline void priceArcs(int begin, int end, const int *source, const int *target,
+                      const double *cost, const signed char *state,
+                      const double *pi, double &min, int &arc) {
+#if defined(__AVX512F__) || defined(__AVX2__)
+  begin = priceLanes(begin, end, source, target, cost, state, pi, min, arc);
+#endif
+  priceArcs<double, double>(begin, end, source, target, cost, state, pi, min,
+                            arc);
+}
+
+inline void priceArcs(int begin, int end, const int *source, const int *target,
+                      const float *cost, const signed char *state,
+                      const double *pi, double &min, int &arc) {
+#if defined(__AVX512F__) || defined(__AVX2__)
+  begin = priceLanes(begin, end, source, target, cost, state, pi, min, arc);
+#endif
+  priceArcs<float, double>(begin, end, source, target, cost, state, pi, min,
+                           arc);
+}
+
+inline void priceArcs(int begin, int end, const int *source, const int *target,
+                      const int64_t *cost, const signed char *state,
+                      const int64_t *pi, int64_t &min, int &arc) {
+#if defined(__AVX512F__) || defined(__AVX2__)
+  begin = priceLanes(begin, end, source, target, cost, state, pi, min, arc);
+#endif
+  priceArcs<int64_t, int64_t>(begin, end, source, target, cost, state, pi,
+                              min, arc);
+}
 
 template <typename V = int, typename C = V> class NetSimplex {
 public:
@@ -72,18 +516,125 @@ public:
   typedef V Value;
   // The type of the arc costs
   typedef C Cost;
+  // The type of the node potentials and of the total cost: double for
+  // floating point costs, so that single precision costs keep accurate
+  // reduced costs
+  typedef typename std::conditional<std::is_floating_point<C>::value, double,
+                                    C>::type Potential;
 
 private:
   typedef std::vector<int> IntVector;
   typedef std::vector<Value> ValueVector;
   typedef std::vector<Cost> CostVector;
+  typedef std::vector<Potential> PotentialVector;
   typedef std::vector<signed char> CharVector;
 
-  typedef std::vector<bool> BoolVector;
+#ifdef KWD_PACKED_ARCS
+  // Fields of an arc read by the pricing, packed in a single record
+  struct ArcData {
+    int source;
+    int target;
+    Cost cost;
+    signed char state;
+  };
+  typedef std::vector<ArcData> ArcDataVector;
+
+  // View on a field of the packed arcs with the interface of the vector
+  // used by the default layout
+  template <typename T, T ArcData::*F> class ArcField {
+  private:
+    ArcDataVector *_arcs;
+    size_t _n;
+
+  public:
+    ArcField() : _arcs(nullptr), _n(0) {}
+    void bind(ArcDataVector *arcs) { _arcs = arcs; }
+
+    T &operator[](size_t i) { return (*_arcs)[i].*F; }
+    const T &operator[](size_t i) const { return (*_arcs)[i].*F; }
+    void set(size_t i, T v) { (*_arcs)[i].*F = v; }
+
+    size_t size() const { return _n; }
+    void clear() { _n = 0; }
+    void reserve(size_t n) { _arcs->reserve(n); }
+    void resize(size_t n, T v = T()) {
+      if (_arcs->size() < n)
+        _arcs->resize(n);
+      for (size_t i = _n; i < n; ++i)
+        (*_arcs)[i].*F = v;
+      _n = n;
+    }
+    void push_back(T v) { resize(_n + 1, v); }
+  };
+
+  typedef ArcField<int, &ArcData::source> ArcIntVector;
+  typedef ArcField<int, &ArcData::target> ArcTargetVector;
+  typedef ArcField<Cost, &ArcData::cost> ArcCostVector;
+  typedef ArcField<signed char, &ArcData::state> ArcStateVector;
+#else
+  // Field of the arcs: the arcs [lo, lo + n) can be read from a list shared
+  // with other networks, and the others are stored here
+  template <typename T> class ArcArray {
+  private:
+    std::vector<T> _own;
+    const T *_shared;
+    size_t _lo;
+    size_t _n;
+
+    size_t own(size_t i) const { return i < _lo ? i : i - _n; }
+
+  public:
+    ArcArray() : _shared(nullptr), _lo(0), _n(0) {}
+
+    T operator[](size_t i) const {
+      if (i - _lo < _n)
+        return _shared[i - _lo];
+      return _own[own(i)];
+    }
+
+    void set(size_t i, T v) {
+      if (i - _lo < _n)
+        throw std::runtime_error("NetSimplex: the shared arcs are read only");
+      _own[own(i)] = v;
+    }
+
+    // Contiguous fields of the arcs [i, end(i))
+    const T *data(size_t i) const {
+      return i - _lo < _n ? _shared + (i - _lo) : _own.data() + own(i);
+    }
+    size_t end(size_t i) const {
+      if (i < _lo)
+        return _lo;
+      return i - _lo < _n ? _lo + _n : size();
+    }
+
+    // Read the next n arcs from the shared array a
+    void share(const T *a, size_t n) {
+      _shared = a;
+      _lo = _own.size();
+      _n = n;
+    }
+
+    size_t size() const { return _own.size() + _n; }
+    void clear() {
+      _own.clear();
+      _shared = nullptr;
+      _lo = _n = 0;
+    }
+    void reserve(size_t n) { _own.reserve(n); }
+    void resize(size_t n, T v = T()) { _own.resize(n - _n, v); }
+    void push_back(T v) { _own.push_back(v); }
+  };
+
+  typedef ArcArray<int> ArcIntVector;
+  typedef ArcArray<int> ArcTargetVector;
+  typedef ArcArray<Cost> ArcCostVector;
+  typedef CharVector ArcStateVector;
+#endif
 
-  // State constants for arcs
-  const bool STATE_TREE = false;
-  const bool STATE_LOWER = true;
+  // State constants for arcs, stored as bytes to allow vectorized pricing
+  const signed char STATE_TREE = 0;
+  const signed char STATE_LOWER = 1;
 
   // Direction constants for tree arcs
   const int DIR_DOWN = -1;
@@ -99,15 +650,23 @@ private:
   // Parameters of the problem
   Value _sum_supply;
 
+#ifdef KWD_PACKED_ARCS
+  // Source, target, cost and state of the arcs, stored in _arcs
+  ArcDataVector _arcs;
+#endif
+
   // Data structures for storing the digraph
-  IntVector _source;
-  IntVector _target;
+  ArcIntVector _source;
+  ArcTargetVector _target;
+
+  // Arcs shared with other networks (see addArcs)
+  std::shared_ptr<const ArcList<Cost>> _shared_arcs;
 
   // Node and arc data
   ValueVector _supply;
   ValueVector _flow;
-  CostVector _cost;
-  CostVector _pi;
+  ArcCostVector _cost;
+  PotentialVector _pi;
 
   // Data for storing the spanning tree structure
   IntVector _parent;
@@ -117,9 +676,27 @@ private:
   IntVector _succ_num;
   IntVector _last_succ;
   CharVector _pred_dir;
-  BoolVector _state;
+  ArcStateVector _state;
   IntVector _dirty_revs;
 
+  // Temporary data used to rebuild the tree in a warm start
+  IntVector _order;
+  IntVector _first_child;
+  IntVector _next_sibling;
+  ValueVector _net;
+
+  // Outgoing and incoming arcs of every node, built on demand
+  IntVector _first_out;
+  IntVector _out_arcs;
+  IntVector _first_in;
+  IntVector _in_arcs;
+  int _adj_arc_num;
+
+  // Temporary data used by the dual network simplex
+  IntVector _dual_cand;
+  IntVector _mark;
+  int _mark_stamp;
+
   int _root;
 
   // Temporary data used in the current pivot iteration
@@ -132,25 +709,46 @@ private:
   double _runtime;
 
   double _timelimit;
+  // Deadline of the runs and optional cancel token
+  std::chrono::steady_clock::time_point _deadline;
+  const CancelToken *_cancel;
   std::string _verbosity;
   double _opt_tolerance;
+  // Tolerance on negative flows, scaled to the precision of Value
+  double _feas_tol;
 
   int N_IT_LOG;
 
+  // Number of threads used to price the arcs
+  int _threads;
+
   uint64_t _iterations;
 
-  double t1, t2, t3, t4, t5, t6;
+  // Pivot statistics of the last run
+  SimplexStats _stats;
+
+  // Column pool of the column generation: the arcs from _pool_first on
+  // are columns, and _col_age counts the rounds that every column spent
+  // out of the basis with positive reduced cost
+  int _pool_first;
+  int _pool_max_age;
+  IntVector _col_age;
+  IntVector _free_cols;
+  ColumnPoolStats _pool_stats;
 
 private:
   // Implementation of the Block Search pivot rule
   class BlockSearchPivotRule {
-  private:
+  protected:
     // References to the NetworkSimplex class
-    const IntVector &_source;
-    const IntVector &_target;
-    const CostVector &_cost;
-    const BoolVector &_state;
-    const CostVector &_pi;
+    const ArcIntVector &_source;
+    const ArcTargetVector &_target;
+    const ArcCostVector &_cost;
+    const ArcStateVector &_state;
+    const PotentialVector &_pi;
+#ifdef KWD_PACKED_ARCS
+    const ArcDataVector &_arcs;
+#endif
     int &_in_arc;
     int _arc_num;
     int _dummy_arc;
@@ -159,17 +757,29 @@ private:
     int _block_size;
     int _next_arc;
 
+    // Number of blocks priced by the last search
+    int _blocks;
+
     // Negative eps
     const double negeps;
 
+    // Candidates found by every thread in a parallel pricing round
+    int _threads;
+    PotentialVector _cand_min;
+    IntVector _cand_arc;
+
   public:
     // Constructor
     BlockSearchPivotRule(NetSimplex &ns)
         : _source(ns._source), _target(ns._target), _cost(ns._cost),
-          _state(ns._state), _pi(ns._pi), _in_arc(ns.in_arc),
+          _state(ns._state), _pi(ns._pi),
+#ifdef KWD_PACKED_ARCS
+          _arcs(ns._arcs),
+#endif
+          _in_arc(ns.in_arc),
           _arc_num(ns._arc_num), _dummy_arc(ns._dummy_arc),
-          _next_arc(ns._next_arc),
-          negeps(std::nextafter(-ns._opt_tolerance, -0.0)) {
+          _next_arc(ns._next_arc), _blocks(0),
+          negeps(std::nextafter(-ns._opt_tolerance, -0.0)), _threads(1) {
       // The main parameters of the pivot rule
       const double BLOCK_SIZE_FACTOR = 1;
       const int MIN_BLOCK_SIZE = 20;
@@ -178,53 +788,451 @@ private:
           (std::max)(int(BLOCK_SIZE_FACTOR *
                          std::sqrt(double(_arc_num) - double(_dummy_arc))),
                      MIN_BLOCK_SIZE);
+
+#ifdef _OPENMP
+      // Smaller blocks are priced faster than a parallel round is started.
+      // Inside a parallel region, as in the batches, the search is
+      // sequential
+      const int MIN_PARALLEL_BLOCK_SIZE = 2048;
+      if (ns._threads > 1 && _block_size >= MIN_PARALLEL_BLOCK_SIZE &&
+          !omp_in_parallel()) {
+        _threads = ns._threads;
+        // Two slots per thread, for two consecutive rounds, with a cache
+        // line between the slots of two threads
+        _cand_min.resize(32 * _threads);
+        _cand_arc.resize(32 * _threads);
+      }
+#endif
+    }
+
+    // Number of threads of the pricing team (1 for the sequential search)
+    int teamThreads() const { return _threads; }
+
+    // Price the arcs in [begin, end) with the kernel of the arc layout
+    void price(int begin, int end, Potential &min, int &arc) const {
+#ifdef KWD_PACKED_ARCS
+      priceArcs(begin, end, _arcs.data(), _pi.data(), min, arc);
+#else
+      // The shared arcs and the own arcs are stored apart
+      while (begin < end) {
+        int stop = (std::min)(end, int(_source.end(begin)));
+        Potential m = min;
+        int a = -1;
+        priceArcs(0, stop - begin, _source.data(begin), _target.data(begin),
+                  _cost.data(begin), _state.data() + begin, _pi.data(), m, a);
+        if (a >= 0) {
+          min = m;
+          arc = begin + a;
+        }
+        begin = stop;
+      }
+#endif
     }
 
+    // Price the arcs in positions [p, p + cnt) of the circular arc list
+    // starting at arc e
+    void priceBlock(int e, int p, int cnt, Potential &min, int &arc) const {
+      int total = _arc_num - _dummy_arc;
+      e = _dummy_arc + (e - _dummy_arc + p) % total;
+      int end = (std::min)(e + cnt, _arc_num);
+      price(e, end, min, arc);
+      cnt -= end - e;
+      if (cnt > 0)
+        price(_dummy_arc, _dummy_arc + cnt, min, arc);
+    }
+
+#ifdef _OPENMP
+    // Find next entering arc with the team of threads of the pivot loop,
+    // which all call this function: every round prices one block per
+    // thread, and the best candidate of all the blocks of the round enters
+    // the basis. The slots of two consecutive rounds are distinct, so a
+    // single barrier per round is needed. Every thread returns the same
+    // value, and the master thread sets the entering arc
+    bool findEnteringArcTeam() {
+      int t = omp_get_thread_num();
+      int nt = omp_get_num_threads();
+      int e = _next_arc < _arc_num ? _next_arc : _dummy_arc;
+      int total = _arc_num - _dummy_arc;
+      int block_size = _block_size;
+      int round = nt * block_size;
+
+      Potential min = negeps;
+      int best = -1;
+      int blocks = 0;
+      for (int p = 0, r = 0; p < total; p += round, r ^= 1) {
+        Potential &cmin = _cand_min[16 * (2 * t + r)];
+        int &carc = _cand_arc[16 * (2 * t + r)];
+        cmin = negeps;
+        carc = -1;
+        int q = p + t * block_size;
+        if (q < total)
+          priceBlock(e, q, (std::min)(block_size, total - q), cmin, carc);
+        blocks += nt;
+#pragma omp barrier
+        for (int i = 0; i < nt; ++i)
+          if (_cand_arc[16 * (2 * i + r)] >= 0 &&
+              _cand_min[16 * (2 * i + r)] < min) {
+            min = _cand_min[16 * (2 * i + r)];
+            best = _cand_arc[16 * (2 * i + r)];
+          }
+        if (best >= 0)
+          break;
+      }
+
+      if (t == 0) {
+        _blocks = blocks;
+        if (best >= 0) {
+          _in_arc = best;
+          _next_arc = best;
+        }
+      }
+      return best >= 0;
+    }
+#endif
+
     // Find next entering arc
     bool findEnteringArc() {
-      Cost min = negeps;
+      Potential min = negeps;
+
+      int e = _next_arc < _arc_num ? _next_arc : _dummy_arc;
+      int left = _arc_num - _dummy_arc;
+      _blocks = 0;
+
+      while (left > 0) {
+        int cnt = (std::min)(_block_size, left);
+        left -= cnt;
+        _blocks++;
+
+        // A block may wrap around the end of the arc list
+        int end = (std::min)(e + cnt, _arc_num);
+        price(e, end, min, _in_arc);
+        cnt -= end - e;
+        e = end;
+        if (e == _arc_num)
+          e = _dummy_arc;
+        if (cnt > 0) {
+          price(e, e + cnt, min, _in_arc);
+          e += cnt;
+        }
 
-      int cnt = _block_size;
+        if (min < negeps) {
+          _next_arc = _in_arc;
+          return true;
+        }
+      }
+
+      return false;
+    }
 
-      for (int e = _next_arc; e < _arc_num; ++e) {
-        Cost c = _state[e] * (_cost[e] + _pi[_source[e]] - _pi[_target[e]]);
-        if (c < min) {
-          min = c;
-          _in_arc = e;
+  }; // class BlockSearchPivotRule
+
+  // Block search with a block size that follows the density of the
+  // improving arcs: while the first block yields an entering arc the block
+  // grows, to select better arcs, and when improving arcs become sparse and
+  // several blocks are priced, it shrinks back
+  class AdaptiveBlockSearchPivotRule : public BlockSearchPivotRule {
+  private:
+    int _min_block_size;
+    int _max_block_size;
+
+  public:
+    // Constructor
+    AdaptiveBlockSearchPivotRule(NetSimplex &ns) : BlockSearchPivotRule(ns) {
+      const int MIN_BLOCK_SIZE = 20;
+      const int RANGE_FACTOR = 8;
+
+      _min_block_size =
+          (std::max)(this->_block_size / RANGE_FACTOR, MIN_BLOCK_SIZE);
+      _max_block_size = (std::max)(this->_block_size * RANGE_FACTOR,
+                                   _min_block_size);
+    }
+
+    // Find next entering arc and adapt the size of the next blocks
+    bool findEnteringArc() {
+      bool found = BlockSearchPivotRule::findEnteringArc();
+      adapt();
+      return found;
+    }
+
+#ifdef _OPENMP
+    bool findEnteringArcTeam() {
+      bool found = BlockSearchPivotRule::findEnteringArcTeam();
+      if (omp_get_thread_num() == 0)
+        adapt();
+      return found;
+    }
+#endif
+
+  private:
+    void adapt() {
+      int b = this->_block_size;
+      if (this->_blocks <= 1)
+        b = b + b / 16;
+      else
+        b = b - b / 8;
+      this->_block_size = (std::min)((std::max)(b, _min_block_size),
+                                     _max_block_size);
+    }
+  }; // class AdaptiveBlockSearchPivotRule
+
+  // Implementation of the Candidate List pivot rule: a major iteration
+  // collects a list of improving arcs, and the following minor iterations
+  // select the best arc still improving in the list
+  class CandidateListPivotRule {
+  private:
+    // References to the NetworkSimplex class
+    const ArcIntVector &_source;
+    const ArcTargetVector &_target;
+    const ArcCostVector &_cost;
+    const ArcStateVector &_state;
+    const PotentialVector &_pi;
+    int &_in_arc;
+    int _arc_num;
+    int _dummy_arc;
+
+    // Pivot rule data
+    IntVector _candidates;
+    int _list_length, _minor_limit;
+    int _curr_length, _minor_count;
+    int _next_arc;
+
+    // Negative eps
+    const double negeps;
+
+  public:
+    // Constructor
+    CandidateListPivotRule(NetSimplex &ns)
+        : _source(ns._source), _target(ns._target), _cost(ns._cost),
+          _state(ns._state), _pi(ns._pi), _in_arc(ns.in_arc),
+          _arc_num(ns._arc_num), _dummy_arc(ns._dummy_arc),
+          _next_arc(ns._next_arc),
+          negeps(std::nextafter(-ns._opt_tolerance, -0.0)) {
+      // The main parameters of the pivot rule
+      const double LIST_LENGTH_FACTOR = 0.25;
+      const int MIN_LIST_LENGTH = 10;
+      const double MINOR_LIMIT_FACTOR = 0.1;
+      const int MIN_MINOR_LIMIT = 3;
+
+      _list_length = (std::max)(
+          int(LIST_LENGTH_FACTOR *
+              std::sqrt(double(_arc_num) - double(_dummy_arc))),
+          MIN_LIST_LENGTH);
+      _minor_limit = (std::max)(int(MINOR_LIMIT_FACTOR * _list_length),
+                                MIN_MINOR_LIMIT);
+      _curr_length = _minor_count = 0;
+      _candidates.resize(_list_length);
+    }
+
+    // Find next entering arc
+    bool findEnteringArc() {
+      Potential min, c;
+      int e;
+
+      if (_curr_length > 0 && _minor_count < _minor_limit) {
+        // Minor iteration: select the best eligible arc from the
+        // current candidate list
+        ++_minor_count;
+        min = negeps;
+        for (int i = 0; i < _curr_length; ++i) {
+          e = _candidates[i];
+          c = _state[e] * (_cost[e] + _pi[_source[e]] - _pi[_target[e]]);
+          if (c < min) {
+            min = c;
+            _in_arc = e;
+          } else if (c >= negeps) {
+            _candidates[i--] = _candidates[--_curr_length];
+          }
+        }
+        if (min < negeps)
+          return true;
+      }
+
+      // Major iteration: build a new candidate list
+      min = negeps;
+      _curr_length = 0;
+      if (_next_arc >= _arc_num)
+        _next_arc = _dummy_arc;
+      for (e = _next_arc; e < _arc_num; ++e) {
+        c = _state[e] * (_cost[e] + _pi[_source[e]] - _pi[_target[e]]);
+        if (c < negeps) {
+          _candidates[_curr_length++] = e;
+          if (c < min) {
+            min = c;
+            _in_arc = e;
+          }
+          if (_curr_length == _list_length)
+            goto search_end;
+        }
+      }
+      for (e = _dummy_arc; e < _next_arc; ++e) {
+        c = _state[e] * (_cost[e] + _pi[_source[e]] - _pi[_target[e]]);
+        if (c < negeps) {
+          _candidates[_curr_length++] = e;
+          if (c < min) {
+            min = c;
+            _in_arc = e;
+          }
+          if (_curr_length == _list_length)
+            goto search_end;
+        }
+      }
+      if (_curr_length == 0)
+        return false;
+
+    search_end:
+      _minor_count = 1;
+      _next_arc = e + 1;
+      return true;
+    }
+
+    // The list rules price on a single thread, and the pivot loop never
+    // runs them in a team
+    int teamThreads() const { return 1; }
+#ifdef _OPENMP
+    bool findEnteringArcTeam() { return findEnteringArc(); }
+#endif
+
+  }; // class CandidateListPivotRule
+
+  // Implementation of the Altering Candidate List pivot rule: the list
+  // keeps the best improving arcs of the previous iterations and it is
+  // extended with a new block of arcs at every iteration
+  class AlteringListPivotRule {
+  private:
+    // References to the NetworkSimplex class
+    const ArcIntVector &_source;
+    const ArcTargetVector &_target;
+    const ArcCostVector &_cost;
+    const ArcStateVector &_state;
+    const PotentialVector &_pi;
+    int &_in_arc;
+    int _arc_num;
+    int _dummy_arc;
+
+    // Pivot rule data
+    int _block_size, _head_length, _curr_length;
+    int _next_arc;
+    IntVector _candidates;
+    PotentialVector _cand_cost;
+
+    // Negative eps
+    const double negeps;
+
+    // Functor class to compare arcs during sort of the candidate list
+    class SortFunc {
+    private:
+      const PotentialVector &_map;
+
+    public:
+      SortFunc(const PotentialVector &map) : _map(map) {}
+      bool operator()(int left, int right) { return _map[left] < _map[right]; }
+    };
+
+    SortFunc _sort_func;
+
+  public:
+    // Constructor
+    AlteringListPivotRule(NetSimplex &ns)
+        : _source(ns._source), _target(ns._target), _cost(ns._cost),
+          _state(ns._state), _pi(ns._pi), _in_arc(ns.in_arc),
+          _arc_num(ns._arc_num), _dummy_arc(ns._dummy_arc),
+          _next_arc(ns._next_arc), _cand_cost(ns._arc_num),
+          negeps(std::nextafter(-ns._opt_tolerance, -0.0)),
+          _sort_func(_cand_cost) {
+      // The main parameters of the pivot rule
+      const double BLOCK_SIZE_FACTOR = 1.0;
+      const int MIN_BLOCK_SIZE = 10;
+      const double HEAD_LENGTH_FACTOR = 0.01;
+      const int MIN_HEAD_LENGTH = 3;
+
+      _block_size = (std::max)(
+          int(BLOCK_SIZE_FACTOR *
+              std::sqrt(double(_arc_num) - double(_dummy_arc))),
+          MIN_BLOCK_SIZE);
+      _head_length =
+          (std::max)(int(HEAD_LENGTH_FACTOR * _block_size), MIN_HEAD_LENGTH);
+      _candidates.resize(_head_length + _block_size);
+      _curr_length = 0;
+    }
+
+    // Find next entering arc
+    bool findEnteringArc() {
+      // Check the current candidate list
+      int e;
+      Potential c;
+      for (int i = 0; i < _curr_length; ++i) {
+        e = _candidates[i];
+        c = _state[e] * (_cost[e] + _pi[_source[e]] - _pi[_target[e]]);
+        if (c < negeps) {
+          _cand_cost[e] = c;
+        } else {
+          _candidates[i--] = _candidates[--_curr_length];
+        }
+      }
+
+      // Extend the list
+      int cnt = _block_size;
+      int limit = _head_length;
+      if (_next_arc >= _arc_num)
+        _next_arc = _dummy_arc;
+
+      for (e = _next_arc; e < _arc_num; ++e) {
+        c = _state[e] * (_cost[e] + _pi[_source[e]] - _pi[_target[e]]);
+        if (c < negeps) {
+          _cand_cost[e] = c;
+          _candidates[_curr_length++] = e;
         }
         if (--cnt == 0) {
-          if (min < negeps)
+          if (_curr_length > limit)
             goto search_end;
+          limit = 0;
           cnt = _block_size;
         }
       }
-
-      for (int e = _dummy_arc; e < _next_arc; ++e) {
-        Cost c = _state[e] * (_cost[e] + _pi[_source[e]] - _pi[_target[e]]);
-        if (c < min) {
-          min = c;
-          _in_arc = e;
+      for (e = _dummy_arc; e < _next_arc; ++e) {
+        c = _state[e] * (_cost[e] + _pi[_source[e]] - _pi[_target[e]]);
+        if (c < negeps) {
+          _cand_cost[e] = c;
+          _candidates[_curr_length++] = e;
         }
         if (--cnt == 0) {
-          if (min < negeps)
+          if (_curr_length > limit)
             goto search_end;
+          limit = 0;
           cnt = _block_size;
         }
       }
-
-      if (min >= negeps)
+      if (_curr_length == 0)
         return false;
 
     search_end:
-      _next_arc = _in_arc;
+      // Perform partial sort operation on the candidate list
+      int new_length = (std::min)(_head_length + 1, _curr_length);
+      std::partial_sort(_candidates.begin(), _candidates.begin() + new_length,
+                        _candidates.begin() + _curr_length, _sort_func);
+
+      // Select the entering arc and remove it from the list
+      _in_arc = _candidates[0];
+      _next_arc = e + 1;
+      _candidates[0] = _candidates[new_length - 1];
+      _curr_length = new_length - 1;
       return true;
     }
 
-  }; // class BlockSearchPivotRule
+    // The list rules price on a single thread, and the pivot loop never
+    // runs them in a team
+    int teamThreads() const { return 1; }
+#ifdef _OPENMP
+    bool findEnteringArcTeam() { return findEnteringArc(); }
+#endif
+
+  }; // class AlteringListPivotRule
 
 public:
   NetSimplex(const char INIT, int node_num, int arc_num)
-      : _node_num(node_num), _arc_num(0), _root(-1), in_arc(-1), join(-1),
+      : _node_num(node_num), _arc_num(0), _adj_arc_num(-1), _mark_stamp(0),
+        _root(-1),
+        in_arc(-1), join(-1),
         u_in(-1), v_in(-1), u_out(-1), v_out(-1),
         MAX((std::numeric_limits<Value>::max)()),
         INF(std::numeric_limits<Value>::has_infinity
@@ -239,9 +1247,47 @@ public:
       throw std::runtime_error(
           "The cost type of NetworkSimplex must be signed");
 
+#ifdef KWD_PACKED_ARCS
+    _source.bind(&_arcs);
+    _target.bind(&_arcs);
+    _cost.bind(&_arcs);
+    _state.bind(&_arcs);
+#endif
+
+    reset(INIT, node_num, arc_num);
+  }
+
+#ifdef KWD_PACKED_ARCS
+  // The views on the packed arcs refer to the arcs of this object
+  NetSimplex(const NetSimplex &) = delete;
+  NetSimplex &operator=(const NetSimplex &) = delete;
+#endif
+
+  // Empty the network and prepare it for node_num nodes and arc_num arcs,
+  // as a new object would be, but keeping the capacity of the vectors
+  void reset(const char INIT, int node_num, int arc_num) {
+    _node_num = node_num;
+    _arc_num = 0;
+    _adj_arc_num = -1;
+    _mark_stamp = 0;
+    _root = -1;
+    in_arc = join = u_in = v_in = u_out = v_out = -1;
+    _runtime = 0.0;
+    _mark.clear();
+
+#ifdef KWD_PACKED_ARCS
+    _arcs.clear();
+#endif
+    _source.clear();
+    _target.clear();
+    _cost.clear();
+    _flow.clear();
+    _state.clear();
+    _shared_arcs.reset();
+
     // Reset data structures
     int all_node_num = _node_num + 1;
-    _supply.resize(all_node_num, 0);
+    _supply.assign(all_node_num, 0);
     _pi.resize(all_node_num);
 
     _parent.resize(all_node_num);
@@ -281,19 +1327,29 @@ public:
     _next_arc = _dummy_arc;
 
     // Interal parameters
-    N_IT_LOG = 1000; // check runtime every IT_LOG iterations
+    _threads = 1;
+    N_IT_LOG = 1000; // log every N_IT_LOG iterations
     _timelimit = std::numeric_limits<double>::max();
+    _deadline = deadlineAfter(_timelimit);
+    _cancel = nullptr;
     _verbosity = KWD_VAL_INFO;
     _opt_tolerance = 1e-06;
+    _feas_tol = (std::max)(
+        FEASIBILITY_TOL, 64 * double(std::numeric_limits<Value>::epsilon()));
     _iterations = 0;
-    // Benchmarking
-    t1 = 0.0, t2 = 0.0, t3 = 0.0, t4 = 0.0, t5 = 0.0, t6 = 0.0;
+    _stats = SimplexStats();
+    _pool_first = -1;
+    _pool_max_age = 1;
+    _col_age.clear();
+    _free_cols.clear();
+    _pool_stats = ColumnPoolStats();
   }
 
   ProblemType run(PivotRule pivot_rule = PivotRule::BLOCK_SEARCH) {
     // shuffle();
     _runtime = 0.0;
     _iterations = 0;
+    _stats = SimplexStats();
 
     // Reset arc variables
     for (int e = 0; e < _arc_num; ++e) {
@@ -310,6 +1366,122 @@ public:
     return start(pivot_rule);
   }
 
+  // Solve again after changing only the node supplies: keep the spanning
+  // tree of the previous solution, repair its primal feasibility, and
+  // continue pivoting from there
+  ProblemType warmRun(PivotRule pivot_rule = PivotRule::BLOCK_SEARCH) {
+    if (_root < 0)
+      return run(pivot_rule);
+
+    _runtime = 0.0;
+    _iterations = 0;
+    _stats = SimplexStats();
+
+    if (!warmInit())
+      return ProblemType::INFEASIBLE;
+    return start(pivot_rule);
+  }
+
+  // Solve starting from the spanning forest of the given arcs, as the flow
+  // support of a solution on a coarser grid: the arcs that close a cycle are
+  // skipped, every tree of the forest hangs from the root, and the flows are
+  // repaired as in warmRun
+  ProblemType seedRun(const std::vector<int> &tree,
+                      PivotRule pivot_rule = PivotRule::BLOCK_SEARCH) {
+    _runtime = 0.0;
+    _iterations = 0;
+    _stats = SimplexStats();
+
+    for (int e = 0; e < _arc_num; ++e) {
+      _state[e] = STATE_LOWER;
+      _flow[e] = 0.0;
+    }
+
+    if (!init())
+      return ProblemType::INFEASIBLE;
+
+    // Spanning forest, by union-find on the nodes
+    IntVector comp(_node_num);
+    for (int u = 0; u < _node_num; ++u)
+      comp[u] = u;
+    auto find = [&comp](int u) {
+      while (comp[u] != u)
+        u = comp[u] = comp[comp[u]];
+      return u;
+    };
+    IntVector head(_node_num, -1);
+    IntVector next, adj;
+    for (int e : tree) {
+      int a = find(_source[e]);
+      int b = find(_target[e]);
+      if (a == b)
+        continue;
+      comp[a] = b;
+      for (int u : {_source[e], _target[e]}) {
+        next.push_back(head[u]);
+        adj.push_back(e);
+        head[u] = int(adj.size()) - 1;
+      }
+    }
+
+    // Hang every tree of the forest from its first node
+    std::vector<char> seen(_node_num, 0);
+    IntVector queue;
+    for (int r = 0; r < _node_num; ++r) {
+      if (seen[r])
+        continue;
+      seen[r] = 1;
+      queue.assign(1, r);
+      for (size_t q = 0; q < queue.size(); ++q) {
+        int u = queue[q];
+        for (int i = head[u]; i != -1; i = next[i]) {
+          int e = adj[i];
+          int v = _source[e] == u ? _target[e] : _source[e];
+          if (seen[v])
+            continue;
+          seen[v] = 1;
+          queue.push_back(v);
+          _state[v] = STATE_LOWER;
+          _flow[v] = 0;
+          _parent[v] = u;
+          _pred[v] = e;
+          _pred_dir[v] = _source[e] == v ? DIR_UP : DIR_DOWN;
+          _state[e] = STATE_TREE;
+        }
+      }
+    }
+    buildThread();
+
+    if (!warmInit())
+      return ProblemType::INFEASIBLE;
+    return start(pivot_rule);
+  }
+
+  // Re-optimize with the dual network simplex after changing only the node
+  // supplies: the previous optimal basis is still dual feasible, and the
+  // dual pivots restore its primal feasibility
+  ProblemType dualRun(PivotRule pivot_rule = PivotRule::BLOCK_SEARCH) {
+    if (_root < 0)
+      return run(pivot_rule);
+
+    _runtime = 0.0;
+    _iterations = 0;
+    _stats = SimplexStats();
+
+    if (!dualInit())
+      return warmRun(pivot_rule);
+
+    ProblemType status = dualStart();
+    if (status == ProblemType::INFEASIBLE)
+      return warmRun(pivot_rule);
+    if (status != ProblemType::OPTIMAL)
+      return status;
+
+    // Primal pivots only if some reduced cost is negative, that is, when
+    // arc costs have changed together with the supplies
+    return start(pivot_rule);
+  }
+
   uint64_t num_arcs() const { return uint64_t(_source.size()) - _dummy_arc; }
 
   uint64_t num_nodes() const { return _node_num; }
@@ -329,69 +1501,126 @@ public:
     return idx;
   }
 
+  // Add the arcs of a list shared with other networks: the arcs are read
+  // from the list, which must not change while the network uses it, and
+  // only their flows and states are stored here. A network can share a
+  // single list
+  void addArcs(std::shared_ptr<const ArcList<Cost>> arcs) {
+    if (_shared_arcs)
+      throw std::runtime_error("NetSimplex: a list of arcs is already shared");
+    size_t n = arcs->num_arcs();
+#ifdef KWD_PACKED_ARCS
+    // The packed arcs keep their own copy
+    for (size_t e = 0; e < n; ++e)
+      addArc(arcs->source[e], arcs->target[e], arcs->cost[e]);
+#else
+    _source.share(arcs->source.data(), n);
+    _target.share(arcs->target.data(), n);
+    _cost.share(arcs->cost.data(), n);
+    _flow.reserve(_flow.size() + n + 2 * _node_num + 1);
+    _state.reserve(_state.size() + n + 2 * _node_num + 1);
+    _flow.resize(_flow.size() + n, 0);
+    _state.resize(_state.size() + n, STATE_LOWER);
+    _arc_num += int(n);
+#endif
+    _shared_arcs = arcs;
+  }
+
   // Change the cost to a single arc
-  void setArcCost(size_t idx, Cost value) { _cost[idx] = value; }
+  void setArcCost(size_t idx, Cost value) { _cost.set(idx, value); }
 
   void setArc(size_t idx, int a, int b, Cost c) {
-    _source[_dummy_arc + idx] = a;
-    _target[_dummy_arc + idx] = b;
-    _cost[_dummy_arc + idx] = c;
+    _source.set(_dummy_arc + idx, a);
+    _target.set(_dummy_arc + idx, b);
+    _cost.set(_dummy_arc + idx, c);
 
     _flow[_dummy_arc + idx] = 0;
     _state[_dummy_arc + idx] = STATE_LOWER;
 
     _arc_num++;
+    _adj_arc_num = -1;
   }
 
-  int updateArcs(const Vars &as) {
-    int new_arc = 0;
-    size_t idx = 0;
-    size_t idx_max = as.size();
-
-    int e = _dummy_arc;
-    int e_max = _arc_num;
+  // Start the column pool of the column generation: the arcs added from
+  // now on are columns, and a column out of the basis with positive reduced
+  // cost for max_age rounds can be replaced by a new column
+  void initColumnPool(int max_age) {
+    // The columns of a previous solve on the same network stay in the pool
+    if (_pool_first < 0) {
+      _pool_first = _arc_num;
+      _col_age.clear();
+    } else
+      std::fill(_col_age.begin(), _col_age.end(), 0);
+    _pool_max_age = (std::max)(1, max_age);
+    _free_cols.clear();
+    _pool_stats = ColumnPoolStats();
+  }
 
-    // Store the new arc variable, replacing an used arc,
-    // out of the basis and with positive reduced cost
-    for (; idx < idx_max; ++idx) {
-      while (e < e_max) {
-        // Replace useless variables with new variables
-        if (_state[e] == STATE_LOWER &&
-            (_cost[e] + _pi[_source[e]] - _pi[_target[e]] > 1e-09))
-          break;
-        ++e;
-      }
-      if (e >= e_max)
-        break;
-      _source[e] = as[idx].a;
-      _target[e] = as[idx].b;
-      _cost[e] = as[idx].c;
-      if (new_arc == 0)
-        _next_arc = e;
-      new_arc++;
+  // Add a round of new columns to the pool: they take the arcs of the
+  // evicted columns first, and then new arcs. Return the number of columns,
+  // and append their arcs to ids, if given
+  int addColumns(const Vars &as, std::vector<int> *ids = nullptr) {
+    if (_pool_first < 0)
+      initColumnPool(_pool_max_age);
+
+    // Age the columns, and collect the evictable ones in the free list
+    _free_cols.clear();
+    for (int e = _pool_first; e < _arc_num; ++e) {
+      int &age = _col_age[e - _pool_first];
+      if (_state[e] == STATE_TREE ||
+          _cost[e] + _pi[_source[e]] - _pi[_target[e]] <= PRIC_TOL)
+        age = 0;
+      else if (++age >= _pool_max_age)
+        _free_cols.push_back(e);
     }
-
-    for (; idx < idx_max; ++idx) {
-      addArc(as[idx].a, as[idx].b, as[idx].c);
-      if (new_arc == 0)
-        _next_arc = e;
-      new_arc++;
+    _pool_stats.rounds++;
+    _pool_stats.evictable = _free_cols.size();
+
+    size_t k = 0;
+    int first = -1;
+    for (const auto &v : as) {
+      int e;
+      if (k < _free_cols.size()) {
+        e = _free_cols[k++];
+        _source.set(e, v.a);
+        _target.set(e, v.b);
+        _cost.set(e, v.c);
+        _col_age[e - _pool_first] = 0;
+        _adj_arc_num = -1;
+        _pool_stats.replaced++;
+      } else {
+        e = int(addArc(v.a, v.b, v.c));
+        _col_age.push_back(0);
+        _pool_stats.appended++;
+      }
+      if (first < 0)
+        first = e;
+      if (ids)
+        ids->push_back(e);
     }
+    if (first >= 0)
+      _next_arc = first;
+    _pool_stats.size = _arc_num - _pool_first;
 
-    return new_arc;
+    return int(as.size());
   }
 
-  Cost totalCost() const {
-    Cost c = 0;
+  // Statistics of the column pool
+  const ColumnPoolStats &poolStats() const { return _pool_stats; }
+
+  // Total cost of the flow, accumulated in the given number type (integer
+  // costs can overflow their own type in the products flow * cost)
+  template <typename Number = Potential> Number totalCost() const {
+    Number c = 0;
     for (int e = _dummy_arc; e < _arc_num; ++e)
       if (_source[e] != _root && _target[e] != _root)
-        c += _flow[e] * _cost[e];
+        c += Number(_flow[e]) * Number(_cost[e]);
 
     return c;
   }
 
-  Cost totalFlow() const {
-    Cost tot_flow = 0;
+  Potential totalFlow() const {
+    Potential tot_flow = 0;
     for (int e = _dummy_arc; e < _arc_num; ++e)
       if (_source[e] != _root && _target[e] != _root)
         tot_flow += _flow[e];
@@ -399,8 +1628,17 @@ public:
     return tot_flow;
   }
 
+  // Arcs with a positive flow, as (source, target, cost)
+  Vars flowSupport() const {
+    Vars vs;
+    for (int e = _dummy_arc; e < _arc_num; ++e)
+      if (_flow[e] > 0 && _source[e] != _root && _target[e] != _root)
+        vs.emplace_back(_source[e], _target[e], double(_cost[e]));
+    return vs;
+  }
+
   // Potential of node n
-  Cost potential(int n) const { return _pi[n]; }
+  Potential potential(int n) const { return _pi[n]; }
 
   // Runtime in milliseconds
   double runtime() const { return _runtime; }
@@ -408,15 +1646,26 @@ public:
   // Number of iterations of simplex algorithms
   uint64_t iterations() const { return _iterations; }
 
-  // Set basic parameters
+  // Pivot statistics of the last run (see KWD_PROFILE)
+  const SimplexStats &stats() const { return _stats; }
+
+  // Set basic parameters: the time limit is counted from this call, and
+  // bounds all the following runs
   void setTimelimit(double t) {
     _timelimit = t;
+    _deadline = deadlineAfter(t);
     PRINT("INFO: change <timelimit> to %f\n", t);
   }
+  // Stop the runs as soon as the token is cancelled (nullptr to disable)
+  void setCancelToken(const CancelToken *token) { _cancel = token; }
   void setOptTolerance(double o) {
     _opt_tolerance = o;
     PRINT("INFO: change <opt_tolerance> to %f\n", o);
   }
+  void setThreads(int t) {
+    _threads = (std::max)(1, t);
+    PRINT("INFO: change <threads> to %d\n", _threads);
+  }
   void setVerbosity(std::string v) {
     _verbosity = v;
     if (v == KWD_VAL_DEBUG)
@@ -428,6 +1677,25 @@ public:
     PRINT("INFO: change <verbosity> to %s\n", v.c_str());
   }
 
+  // Set all the parameters without logging, as needed by the worker
+  // threads of a batch
+  void setParams(double timelimit, const CancelToken *token,
+                 const std::string &verbosity, double opt_tolerance,
+                 int threads) {
+    _timelimit = timelimit;
+    _deadline = deadlineAfter(timelimit);
+    _cancel = token;
+    _opt_tolerance = opt_tolerance;
+    _threads = (std::max)(1, threads);
+    _verbosity = verbosity;
+    if (verbosity == KWD_VAL_DEBUG)
+      N_IT_LOG = 100000;
+    if (verbosity == KWD_VAL_INFO)
+      N_IT_LOG = 10000000;
+    if (verbosity == KWD_VAL_SILENT)
+      N_IT_LOG = 0;
+  }
+
   // Check feasibility
   ProblemType checkFeasibility() {
     for (int e = 0; e != _dummy_arc; ++e)
@@ -479,17 +1747,7 @@ private:
     }
 
     // Initialize artifical cost
-    Cost ART_COST;
-    if (std::numeric_limits<Cost>::is_exact) {
-      ART_COST = (std::numeric_limits<Cost>::max)() / 2 + 1;
-    } else {
-      ART_COST = 0;
-      for (int i = _dummy_arc; i != _arc_num; ++i) {
-        if (_cost[i] > ART_COST)
-          ART_COST = _cost[i];
-      }
-      ART_COST = (ART_COST + 1) * _node_num;
-    }
+    Cost ART_COST = artificialCost();
 
     // Set data for the artificial root node
     // TODO: POSSO USARLI PER LA MASSA SBILANCIATA!
@@ -517,28 +1775,431 @@ private:
       if (_supply[u] >= 0) {
         _pred_dir[u] = DIR_UP;
         _pi[u] = 0;
-        _source[e] = u;
-        _target[e] = _root;
+        _source.set(e, u);
+        _target.set(e, _root);
         _flow[e] = _supply[u];
-        _cost[e] = 0;
+        _cost.set(e, 0);
       } else {
         _pred_dir[u] = DIR_DOWN;
         _pi[u] = ART_COST;
-        _source[e] = _root;
-        _target[e] = u;
+        _source.set(e, _root);
+        _target.set(e, u);
         _flow[e] = -_supply[u];
-        _cost[e] = ART_COST;
+        _cost.set(e, ART_COST);
+      }
+    }
+
+    return true;
+  }
+
+  // Cost of the artificial arcs entering the root node
+  Cost artificialCost() const {
+    if (std::numeric_limits<Cost>::is_exact)
+      return (std::numeric_limits<Cost>::max)() / 2 + 1;
+
+    Cost art_cost = 0;
+    for (int i = _dummy_arc; i != _arc_num; ++i) {
+      if (_cost[i] > art_cost)
+        art_cost = _cost[i];
+    }
+    return (art_cost + 1) * _node_num;
+  }
+
+  // Build the lists of outgoing and incoming arcs of every node (without
+  // dummy arcs)
+  void buildAdjacency() {
+    _first_out.assign(_node_num + 2, 0);
+    _first_in.assign(_node_num + 2, 0);
+    for (int e = _dummy_arc; e != _arc_num; ++e) {
+      _first_out[_source[e] + 2]++;
+      _first_in[_target[e] + 2]++;
+    }
+    for (int u = 2; u <= _node_num + 1; ++u) {
+      _first_out[u] += _first_out[u - 1];
+      _first_in[u] += _first_in[u - 1];
+    }
+    _out_arcs.resize(_arc_num - _dummy_arc);
+    _in_arcs.resize(_arc_num - _dummy_arc);
+    for (int e = _dummy_arc; e != _arc_num; ++e) {
+      _out_arcs[_first_out[_source[e] + 1]++] = e;
+      _in_arcs[_first_in[_target[e] + 1]++] = e;
+    }
+    _adj_arc_num = _arc_num;
+  }
+
+  // Arc going in the opposite direction of arc e, or -1 if it does not exist
+  int reverseArc(int e) {
+    if (_adj_arc_num != _arc_num)
+      buildAdjacency();
+    int a = _source[e];
+    int b = _target[e];
+    for (int i = _first_out[b], i_max = _first_out[b + 1]; i < i_max; ++i)
+      if (_target[_out_arcs[i]] == a)
+        return _out_arcs[i];
+    return -1;
+  }
+
+  // Initialize the data structures from the previous spanning tree
+  bool warmInit() {
+    if (_node_num == 0)
+      return false;
+
+    _sum_supply = 0;
+    for (int i = 0; i != _node_num; ++i)
+      _sum_supply += _supply[i];
+    _supply[_root] = -_sum_supply;
+
+    Cost ART_COST = artificialCost();
+
+    // Nodes in preorder, following the thread from the root
+    _order.resize(_node_num + 1);
+    for (int i = 0, u = _root; i <= _node_num; ++i, u = _thread[u])
+      _order[i] = u;
+
+    // Compute the tree flows bottom-up: the flow on the arc entering the
+    // subtree of u is fixed by the total supply of the subtree. When the
+    // flow would be negative, the subtree is hooked to the root with its
+    // own artificial arc, which keeps the basis primal feasible
+    _net.resize(_node_num + 1);
+    for (int u = 0; u != _node_num; ++u)
+      _net[u] = _supply[u];
+    _net[_root] = 0;
+
+    for (int i = _node_num; i > 0; --i) {
+      int u = _order[i];
+      int e = _pred[u];
+      Value f = _pred_dir[u] == DIR_UP ? _net[u] : -_net[u];
+      if (e >= _dummy_arc && f >= 0) {
+        _flow[e] = f;
+        _net[_parent[u]] += _net[u];
+        continue;
+      }
+
+      if (e >= _dummy_arc) {
+        _state[e] = STATE_LOWER;
+        _flow[e] = 0;
+        // Replace the arc with its reverse arc, if any: the tree keeps its
+        // shape and only the potentials of the subtree change
+        int r = reverseArc(e);
+        if (r != -1 && _state[r] == STATE_LOWER) {
+          _pred[u] = r;
+          _pred_dir[u] = -_pred_dir[u];
+          _state[r] = STATE_TREE;
+          _flow[r] = -f;
+          _net[_parent[u]] += _net[u];
+          continue;
+        }
+      }
+      e = u;
+      _parent[u] = _root;
+      _pred[u] = e;
+      _state[e] = STATE_TREE;
+      if (_net[u] >= 0) {
+        _pred_dir[u] = DIR_UP;
+        _source.set(e, u);
+        _target.set(e, _root);
+        _flow[e] = _net[u];
+        _cost.set(e, 0);
+      } else {
+        _pred_dir[u] = DIR_DOWN;
+        _source.set(e, _root);
+        _target.set(e, u);
+        _flow[e] = -_net[u];
+        _cost.set(e, ART_COST);
+      }
+    }
+
+    buildThread();
+
+    return true;
+  }
+
+  // Rebuild thread, successor and potential data from the parent links
+  void buildThread() {
+    _first_child.assign(_node_num + 1, -1);
+    _next_sibling.resize(_node_num + 1);
+    for (int u = _node_num - 1; u >= 0; --u) {
+      _next_sibling[u] = _first_child[_parent[u]];
+      _first_child[_parent[u]] = u;
+    }
+
+    _pi[_root] = 0;
+    int last = _root;
+    int u = _root;
+    while (true) {
+      if (_first_child[u] != -1) {
+        int v = _first_child[u];
+        _thread[last] = v;
+        _rev_thread[v] = last;
+        last = v;
+        _pi[v] = _pi[u] - _pred_dir[v] * _cost[_pred[v]];
+        u = v;
+      } else {
+        // Close the subtrees whose last successor is u
+        _last_succ[u] = last;
+        while (u != _root && _next_sibling[u] == -1) {
+          u = _parent[u];
+          _last_succ[u] = last;
+        }
+        if (u == _root)
+          break;
+        int v = _next_sibling[u];
+        _thread[last] = v;
+        _rev_thread[v] = last;
+        last = v;
+        _pi[v] = _pi[_parent[v]] - _pred_dir[v] * _cost[_pred[v]];
+        u = v;
+      }
+    }
+    _thread[last] = _root;
+    _rev_thread[_root] = last;
+
+    // Subtree sizes, bottom-up along the reverse thread
+    for (int v = 0; v <= _node_num; ++v)
+      _succ_num[v] = 1;
+    for (int v = last; v != _root; v = _rev_thread[v])
+      _succ_num[_parent[v]] += _succ_num[v];
+  }
+
+  // Compute the flows of the previous spanning tree for the new supplies,
+  // without repairing negative flows. Return false if the basis is not dual
+  // feasible, since the dual pivots cannot start from it
+  bool dualInit() {
+    if (_node_num == 0)
+      return false;
+
+    _sum_supply = 0;
+    for (int i = 0; i != _node_num; ++i)
+      _sum_supply += _supply[i];
+    _supply[_root] = -_sum_supply;
+
+    Cost ART_COST = artificialCost();
+
+    _order.resize(_node_num + 1);
+    for (int i = 0, u = _root; i <= _node_num; ++i, u = _thread[u])
+      _order[i] = u;
+
+    // Tree flows, bottom-up along the reverse thread
+    _net.resize(_node_num + 1);
+    for (int u = 0; u != _node_num; ++u)
+      _net[u] = _supply[u];
+    _net[_root] = 0;
+
+    _dual_cand.clear();
+    for (int i = _node_num; i > 0; --i) {
+      int u = _order[i];
+      int e = _pred[u];
+      _flow[e] = _pred_dir[u] == DIR_UP ? _net[u] : -_net[u];
+      _net[_parent[u]] += _net[u];
+      if (_flow[e] < -_feas_tol)
+        _dual_cand.push_back(e);
+      if (e < _dummy_arc)
+        _cost.set(e, _pred_dir[u] == DIR_UP ? 0 : ART_COST);
+    }
+
+    // Potentials of the tree for the current arc costs
+    _pi[_root] = 0;
+    for (int i = 1; i <= _node_num; ++i) {
+      int u = _order[i];
+      _pi[u] = _pi[_parent[u]] - _pred_dir[u] * _cost[_pred[u]];
+    }
+
+    for (int e = _dummy_arc; e != _arc_num; ++e)
+      if (_state[e] == STATE_LOWER &&
+          _cost[e] + _pi[_source[e]] - _pi[_target[e]] < -_opt_tolerance)
+        return false;
+
+    if (_adj_arc_num != _arc_num)
+      buildAdjacency();
+    _mark.resize(_node_num + 1, 0);
+
+    return true;
+  }
+
+  // Child node of a tree arc
+  int treeChild(int e) const {
+    return _pred[_source[e]] == e ? _source[e] : _target[e];
+  }
+
+  // Select the leaving arc of the dual network simplex: the most negative
+  // flow among a block of candidates. Return false if the tree flows are
+  // feasible
+  bool findDualLeavingArc() {
+    const int block_size =
+        (std::max)(int(std::sqrt(double(_dual_cand.size()))), 20);
+    Value min = -_feas_tol;
+    int best = -1;
+    int cnt = 0;
+    size_t i = 0;
+    while (i < _dual_cand.size() && cnt < block_size) {
+      int e = _dual_cand[i];
+      if (_state[e] != STATE_TREE || _flow[e] >= -_feas_tol) {
+        _dual_cand[i] = _dual_cand.back();
+        _dual_cand.pop_back();
+        continue;
       }
+      if (_flow[e] < min) {
+        min = _flow[e];
+        best = e;
+      }
+      ++cnt;
+      ++i;
     }
+    if (best == -1)
+      return false;
 
+    u_out = treeChild(best);
+    delta = -_flow[best];
     return true;
   }
 
+  // Select the entering arc of the dual network simplex: the arc crossing
+  // the cut of the subtree of u_out with minimum reduced cost
+  bool findDualEnteringArc() {
+    // Mark the nodes in the subtree of u_out
+    if (++_mark_stamp == std::numeric_limits<int>::max()) {
+      std::fill(_mark.begin(), _mark.end(), 0);
+      _mark_stamp = 1;
+    }
+    int stamp = _mark_stamp;
+    int size = _succ_num[u_out];
+    int end = _thread[_last_succ[u_out]];
+    for (int u = u_out; u != end; u = _thread[u])
+      _mark[u] = stamp;
+
+    // The flow on the leaving arc must increase: if the arc leaves the
+    // subtree, the entering arc must enter it, and vice versa
+    bool into = _pred_dir[u_out] == DIR_UP;
+
+    Potential min = (std::numeric_limits<Potential>::max)();
+    in_arc = -1;
+    auto check = [&](int e) {
+      if (_state[e] != STATE_LOWER)
+        return;
+      if ((_mark[_source[e]] == stamp) == into ||
+          (_mark[_target[e]] == stamp) != into)
+        return;
+      Potential c = _cost[e] + _pi[_source[e]] - _pi[_target[e]];
+      if (c < min) {
+        min = c;
+        in_arc = e;
+      }
+    };
+
+    // Scan the arcs of the smaller side of the cut
+    if (2 * size <= _node_num + 1) {
+      for (int u = u_out; u != end; u = _thread[u]) {
+        if (into)
+          for (int i = _first_in[u], i_max = _first_in[u + 1]; i < i_max; ++i)
+            check(_in_arcs[i]);
+        else
+          for (int i = _first_out[u], i_max = _first_out[u + 1]; i < i_max;
+               ++i)
+            check(_out_arcs[i]);
+      }
+    } else {
+      for (int u = end; u != u_out; u = _thread[u]) {
+        if (u == _root)
+          continue;
+        if (into)
+          for (int i = _first_out[u], i_max = _first_out[u + 1]; i < i_max;
+               ++i)
+            check(_out_arcs[i]);
+        else
+          for (int i = _first_in[u], i_max = _first_in[u + 1]; i < i_max; ++i)
+            check(_in_arcs[i]);
+      }
+    }
+
+    if (in_arc == -1)
+      return false;
+
+    if (_mark[_source[in_arc]] == stamp) {
+      u_in = _source[in_arc];
+      v_in = _target[in_arc];
+    } else {
+      u_in = _target[in_arc];
+      v_in = _source[in_arc];
+    }
+    return true;
+  }
+
+  // Push delta along the cycle of the entering arc, which brings the flow of
+  // the leaving arc to zero
+  void changeDualFlow() {
+    int out_arc = _pred[u_out];
+    _flow[in_arc] += delta;
+    for (int u = _source[in_arc]; u != join; u = _parent[u]) {
+      _flow[_pred[u]] -= _pred_dir[u] * delta;
+      if (_flow[_pred[u]] < -_feas_tol)
+        _dual_cand.push_back(_pred[u]);
+    }
+    for (int u = _target[in_arc]; u != join; u = _parent[u]) {
+      _flow[_pred[u]] += _pred_dir[u] * delta;
+      if (_flow[_pred[u]] < -_feas_tol)
+        _dual_cand.push_back(_pred[u]);
+    }
+    _flow[out_arc] = 0;
+
+    _state[in_arc] = STATE_TREE;
+    _state[out_arc] = STATE_LOWER;
+  }
+
+  // Execute the dual network simplex algorithm
+  ProblemType dualStart() {
+    auto start_tt = std::chrono::steady_clock::now();
+    ProblemType status;
+    if (interrupted(status))
+      return status;
+
+    bool found = false;
+    while (true) {
+      KWD_PROFILE_PHASE(_stats.t_leave, found = findDualLeavingArc());
+      if (!found)
+        break;
+      KWD_PROFILE_PHASE(_stats.t_enter, found = findDualEnteringArc());
+      if (!found)
+        return ProblemType::INFEASIBLE;
+      KWD_PROFILE_PHASE(_stats.t_join, findJoinNode());
+      KWD_PROFILE_PHASE(_stats.t_flow, changeDualFlow());
+      KWD_PROFILE_PHASE(_stats.t_tree, updateTreeStructure());
+      KWD_PROFILE_PHASE(_stats.t_potential, updatePotential());
+      KWD_PROFILE_ADD(_stats.subtree_nodes, _succ_num[u_in]);
+      KWD_PROFILE_ADD(_stats.pivots, 1);
+
+      _iterations++;
+      if (_iterations % CHECK_INTERVAL == 0 && interrupted(status))
+        return status;
+      if (N_IT_LOG > 0) {
+        if (_iterations % N_IT_LOG == 0) {
+          auto end_t = std::chrono::steady_clock::now();
+          double tot =
+              double(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         end_t - start_tt)
+                         .count()) /
+              1000000000;
+          if (_verbosity == KWD_VAL_DEBUG)
+            PRINT("NetSIMPLEX dual loop | it: %ld, runtime: %.4f\n",
+                  _iterations, tot);
+        }
+      }
+    }
+
+    auto end_t = std::chrono::steady_clock::now();
+    _runtime += double(std::chrono::duration_cast<std::chrono::milliseconds>(
+                           end_t - start_tt)
+                           .count()) /
+                1000;
+
+    return ProblemType::OPTIMAL;
+  }
+
   // Find the join node
   void findJoinNode() {
     int u = _source[in_arc];
     int v = _target[in_arc];
     while (u != v) {
+      KWD_PROFILE_ADD(_stats.cycle_nodes, 1);
       if (_succ_num[u] < _succ_num[v]) {
         u = _parent[u];
       } else {
@@ -607,8 +2268,12 @@ private:
     if (delta > 0) {
       _flow[in_arc] += delta;
 
+      // The two paths go in parallel only with pricing threads: a single
+      // threaded simplex may run inside a batch of parallel solves, and
+      // the master of the pricing team pivots alone
 #ifdef _OPENMP
-#pragma omp parallel sections num_threads(2)
+#pragma omp parallel sections num_threads(2)                                   \
+    if (_threads > 1 && !omp_in_parallel())
       {
 #pragma omp section
 #else
@@ -677,6 +2342,7 @@ private:
       _dirty_revs.clear();
       _dirty_revs.push_back(v_in);
       while (stem != u_out) {
+        KWD_PROFILE_ADD(_stats.stem_nodes, 1);
         // Insert the next stem node into the thread list
         next_stem = _parent[stem];
         _thread[last] = next_stem;
@@ -762,7 +2428,7 @@ private:
 
   // Update potentials in the subtree that has been moved
   void updatePotential() {
-    Cost sigma = _pi[v_in] - _pi[u_in] - _pred_dir[u_in] * _cost[in_arc];
+    Potential sigma = _pi[v_in] - _pi[u_in] - _pred_dir[u_in] * _cost[in_arc];
     int end = _thread[_last_succ[u_in]];
 
     for (int u = u_in; u != end; u = _thread[u]) {
@@ -776,92 +2442,117 @@ private:
     switch (pivot_rule) {
     case PivotRule::BLOCK_SEARCH:
       return start<BlockSearchPivotRule>();
+    case PivotRule::CANDIDATE_LIST:
+      return start<CandidateListPivotRule>();
+    case PivotRule::ALTERING_LIST:
+      return start<AlteringListPivotRule>();
+    case PivotRule::ADAPTIVE_BLOCK_SEARCH:
+      return start<AdaptiveBlockSearchPivotRule>();
     }
     return ProblemType::INFEASIBLE; // avoid warning
   }
 
+  // Check the deadline and the cancel token, and set the status to report
+  bool interrupted(ProblemType &status) const {
+    if (_cancel != nullptr && _cancel->cancelled()) {
+      status = ProblemType::CANCELLED;
+      return true;
+    }
+    if (std::chrono::steady_clock::now() > _deadline) {
+      status = ProblemType::TIMELIMIT;
+      return true;
+    }
+    return false;
+  }
+
+  // Pivot on the entering arc in_arc: return false when the run has to
+  // stop, with the status to report
+  bool pivot(ProblemType &status,
+             std::chrono::steady_clock::time_point start_tt) {
+    KWD_PROFILE_PHASE(_stats.t_join, findJoinNode());
+    KWD_PROFILE_PHASE(_stats.t_leave, findLeavingArc());
+    KWD_PROFILE_ADD(_stats.degenerate_pivots, delta == 0);
+    KWD_PROFILE_PHASE(_stats.t_flow, changeFlow());
+    KWD_PROFILE_PHASE(_stats.t_tree, updateTreeStructure());
+    KWD_PROFILE_PHASE(_stats.t_potential, updatePotential());
+    KWD_PROFILE_ADD(_stats.subtree_nodes, _succ_num[u_in]);
+    KWD_PROFILE_ADD(_stats.pivots, 1);
+
+    // Add as log file
+    _iterations++;
+    if (_iterations % CHECK_INTERVAL == 0 && interrupted(status))
+      return false;
+    if (N_IT_LOG > 0) {
+      if (_iterations % N_IT_LOG == 0) {
+        auto end_t = std::chrono::steady_clock::now();
+        double tot =
+            double(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       end_t - start_tt)
+                       .count()) /
+            1000000000;
+        if (_verbosity == KWD_VAL_DEBUG)
+          PRINT("NetSIMPLEX inner loop | it: %ld, distance: %.4f, runtime: "
+                "%.4f\n",
+                _iterations, totalCost<double>(), tot);
+      }
+    }
+    return true;
+  }
+
+#ifdef _OPENMP
+  // Pivot loop with a team of pricing threads that lives as long as the
+  // loop: the threads price the blocks together, and the master thread
+  // pivots while the others wait at the barrier. Return false when the run
+  // has to stop, with the status to report
+  template <typename PivotRuleImpl>
+  bool teamLoop(PivotRuleImpl &rule, ProblemType &status,
+                std::chrono::steady_clock::time_point start_tt) {
+    bool stop = false;
+#pragma omp parallel num_threads(rule.teamThreads())
+    {
+      bool master = omp_get_thread_num() == 0;
+      while (true) {
+        bool found;
+        if (master) {
+          KWD_PROFILE_PHASE(_stats.t_enter, found = rule.findEnteringArcTeam());
+        } else
+          found = rule.findEnteringArcTeam();
+        if (!found)
+          break;
+
+        if (master && !pivot(status, start_tt))
+          stop = true;
+#pragma omp barrier
+        if (stop)
+          break;
+      }
+    }
+    return !stop;
+  }
+#endif
+
   template <typename PivotRuleImpl> ProblemType start() {
     auto start_tt = std::chrono::steady_clock::now();
-    PivotRuleImpl pivot(*this);
-
-    // Benchmarking
+    ProblemType status;
+    if (interrupted(status))
+      return status;
+    PivotRuleImpl rule(*this);
 
     // Execute the Network Simplex algorithm
-    while (true) {
-      // auto start_t = std::chrono::steady_clock::now();
-      bool stop = pivot.findEnteringArc();
-      // auto end_t = std::chrono::steady_clock::now();
-      // t1 += double(std::chrono::duration_cast<std::chrono::nanoseconds>(end_t
-      // -
-      //                                                                  start_t)
-      //                 .count()) /
-      //      1000000000;
-
-      if (!stop)
-        break;
-
-      // start_t = std::chrono::steady_clock::now();
-      findJoinNode();
-      // end_t = std::chrono::steady_clock::now();
-      // t2 += double(std::chrono::duration_cast<std::chrono::nanoseconds>(end_t
-      // -
-      //                                                                  start_t)
-      //                 .count()) /
-      //      1000000000;
-
-      // start_t = std::chrono::steady_clock::now();
-      findLeavingArc();
-      // end_t = std::chrono::steady_clock::now();
-      // t3 += double(std::chrono::duration_cast<std::chrono::nanoseconds>(end_t
-      // -
-      //                                                                  start_t)
-      //                 .count()) /
-      //      1000000000;
-
-      // start_t = std::chrono::steady_clock::now();
-      changeFlow();
-      // end_t = std::chrono::steady_clock::now();
-      // t4 += double(std::chrono::duration_cast<std::chrono::nanoseconds>(end_t
-      // -
-      //                                                                  start_t)
-      //                 .count()) /
-      //      1000000000;
-
-      // start_t = std::chrono::steady_clock::now();
-      updateTreeStructure();
-      // end_t = std::chrono::steady_clock::now();
-      // t5 += double(std::chrono::duration_cast<std::chrono::nanoseconds>(end_t
-      // -
-      //                                                                  start_t)
-      //                 .count()) /
-      //      1000000000;
-
-      // start_t = std::chrono::steady_clock::now();
-      updatePotential();
-      // end_t = std::chrono::steady_clock::now();
-      // t6 += double(std::chrono::duration_cast<std::chrono::nanoseconds>(end_t
-      // -
-      //                                                                  start_t)
-      //                 .count()) /
-      //      1000000000;
-
-      // Add as log file
-      _iterations++;
-      if (N_IT_LOG > 0) {
-        if (_iterations % N_IT_LOG == 0) {
-          auto end_t = std::chrono::steady_clock::now();
-          double tot =
-              double(std::chrono::duration_cast<std::chrono::nanoseconds>(
-                         end_t - start_tt)
-                         .count()) /
-              1000000000;
-          if (tot > _timelimit)
-            return ProblemType::TIMELIMIT;
-          if (_verbosity == KWD_VAL_DEBUG)
-            PRINT("NetSIMPLEX inner loop | it: %ld, distance: %.4f, runtime: "
-                  "%.4f\n",
-                  _iterations, totalCost(), tot);
-        }
+#ifdef _OPENMP
+    if (rule.teamThreads() > 1) {
+      if (!teamLoop(rule, status, start_tt))
+        return status;
+    } else
+#endif
+    {
+      bool found = false;
+      while (true) {
+        KWD_PROFILE_PHASE(_stats.t_enter, found = rule.findEnteringArc());
+        if (!found)
+          break;
+        if (!pivot(status, start_tt))
+          return status;
       }
     }
 
@@ -871,11 +2562,10 @@ private:
                            .count()) /
                 1000;
 
-    if (_verbosity == KWD_VAL_DEBUG)
-      PRINT("NetSIMPLEX outer loop | enter: %.3f, join: %.3f, leave: %.3f, "
-            "change: %.3f, tree: %.3f, "
-            "potential: %.3f, runtime: %.3f\n",
-            t1, t2, t3, t4, t5, t6, _runtime);
+    if (_verbosity == KWD_VAL_DEBUG) {
+      PRINT("NetSIMPLEX outer loop | runtime: %.3f\n", _runtime);
+      _stats.dump();
+    }
 
     return ProblemType::OPTIMAL;
   }
@@ -0,0 +1,768 @@
+/**
+ * @fileoverview Copyright (c) 2019-2021, Stefano Gualandi,
+ *               via Ferrata, 1, I-27100, Pavia, Italy
+ *
+ * @author stefano.gualandi@gmail.com (Stefano Gualandi)
+ *
+ */
+
+// ORIGINAL SOURCE CODE FOR THE NETWORK SIMPLEX BASIS DATA STRUCTURE TAKE FROM:
+// WEBSITE: https://lemon.cs.elte.hu
+
+/* ORIGINAL LICENSE FILE:
+ * This file is a part of LEMON, a generic C++ optimization library.
+ *
+ * Copyright (C) 2003-2013
+ * Egervary Jeno Kombinatorikus Optimalizalasi Kutatocsoport
+ * (Egervary Research Group on Combinatorial Optimization, EGRES).
+ *
+ * Permission to use, modify and distribute this software is granted
+ * provided that this copyright notice appears in all copies. For
+ * precise terms see the accompanying LICENSE file.
+ *
+ * This software is provided "AS IS" with no warranty of any kind,
+ * express or implied, and with no claim as to its suitability for any
+ * purpose.
+ *
+ */
+
+#pragma once
+
+#include "KWD_NetSimplex.h"
+
+#include <memory>
+
+namespace KWD {
+
+// Read-only topology of the L-approximation graph of a regular grid: the
+// cell of every node in a grid padded with a border of empty cells, and
+// the table of directions with their costs. It is shared by every
+// NetSimplexGrid that solves on the same support
+template <typename C = double> class GridNetwork {
+public:
+  // The type of the arc costs
+  typedef C Cost;
+
+  typedef std::vector<int> IntVector;
+  typedef std::vector<Cost> CostVector;
+
+  GridNetwork(int node_num, int xmax, int ymax, int border)
+      : _node_num(node_num), _xmax(xmax), _ymax(ymax), _border(border),
+        _width(ymax + 2 * border), _dir_num(0) {
+    // Grid padded with a border of empty cells: no bound check is needed
+    // for the directions within the border
+    _grid.resize(size_t(_xmax + 2 * _border) * size_t(_width), -1);
+    _pos.resize(_node_num, 0);
+  }
+
+  // Place node i on the cell (x, y) of the grid
+  void setNode(int i, int x, int y) {
+    if (x < 0 || x >= _xmax || y < 0 || y >= _ymax)
+      throw std::runtime_error("ERROR 303: node out of the grid");
+    _pos[i] = (x + _border) * _width + (y + _border);
+    _grid[_pos[i]] = i;
+  }
+
+  // Add the arcs from every node along the direction (v, w)
+  void addDirection(int v, int w, Cost c) {
+    if (std::abs(v) > _border || std::abs(w) > _border)
+      throw std::runtime_error("ERROR 304: direction larger than the border");
+    if (double(_node_num) * (_dir_num + 2) >
+        double((std::numeric_limits<int>::max)()))
+      throw std::runtime_error("ERROR 305: too many implicit arcs");
+    _offset.push_back(v * _width + w);
+    _dir_cost.push_back(c);
+    _dir_num++;
+  }
+
+  int nodeNum() const { return _node_num; }
+  int dirNum() const { return _dir_num; }
+
+  // Node of every cell of the padded grid, -1 for empty cells
+  const IntVector &grid() const { return _grid; }
+  // Cell of every node in the padded grid
+  const IntVector &pos() const { return _pos; }
+  // Offset in the padded grid and cost of every direction
+  const IntVector &offset() const { return _offset; }
+  const CostVector &dirCost() const { return _dir_cost; }
+
+  // Number of arcs of the graph
+  size_t num_arcs() const {
+    size_t m = 0;
+    for (int u = 0; u < _node_num; ++u)
+      for (int k = 0; k < _dir_num; ++k)
+        if (_grid[_pos[u] + _offset[k]] >= 0)
+          m++;
+    return m;
+  }
+
+private:
+  int _node_num;
+  int _xmax;
+  int _ymax;
+  int _border;
+  int _width;
+
+  IntVector _grid;
+  IntVector _pos;
+
+  IntVector _offset;
+  CostVector _dir_cost;
+  int _dir_num;
+};
+
+// Network simplex for the L-approximation graph of a regular grid.
+// Every node lies on a cell of the grid, and it has an arc towards every
+// node reached by one of the given directions (v, w) with cost c. Arc ids
+// are implicit, the arc k of node u is u * K + k, where K is the number of
+// directions: targets and costs are computed from the grid and the table
+// of directions, and only the arcs of the spanning tree are stored, with
+// their flow, in the node arrays. The grid and the directions live in a
+// GridNetwork, that several solvers can share.
+template <typename V = double, typename C = V> class NetSimplexGrid {
+public:
+  // The type of the flow amounts and supply values
+  typedef V Value;
+  // The type of the arc costs
+  typedef C Cost;
+
+private:
+  typedef std::vector<int> IntVector;
+  typedef std::vector<Value> ValueVector;
+  typedef std::vector<Cost> CostVector;
+  typedef std::vector<signed char> CharVector;
+
+  // Direction constants for tree arcs
+  const int DIR_DOWN = -1;
+  const int DIR_UP = 1;
+
+  // Underlying grid, owned by this solver when it is not shared
+  std::shared_ptr<const GridNetwork<Cost>> _net;
+  std::shared_ptr<GridNetwork<Cost>> _own;
+  int _node_num;
+
+  // Views on the grid and on the directions of the network
+  const IntVector &_grid;
+  const IntVector &_pos;
+  const IntVector &_offset;
+  const CostVector &_dir_cost;
+  int _dir_num;
+
+  // Arc id where begin the dummy arcs between nodes and root
+  int _dummy_arc;
+
+  // Node data
+  ValueVector _supply;
+  CostVector _pi;
+
+  // Data for storing the spanning tree structure
+  IntVector _parent;
+  IntVector _pred;
+  ValueVector _pred_flow;
+  IntVector _thread;
+  IntVector _rev_thread;
+  IntVector _succ_num;
+  IntVector _last_succ;
+  CharVector _pred_dir;
+  IntVector _dirty_revs;
+
+  // Cost of the dummy arc from the root to the nodes with negative supply
+  Cost _art_cost;
+
+  int _root;
+  int _next_node;
+
+  // Temporary data used in the current pivot iteration
+  int in_arc, join, u_in, v_in, u_out, v_out;
+  Value delta;
+
+  const Value MAX;
+  const Value INF;
+
+  double _runtime;
+
+  double _timelimit;
+  // Deadline of the runs and optional cancel token
+  std::chrono::steady_clock::time_point _deadline;
+  const CancelToken *_cancel;
+  std::string _verbosity;
+  double _opt_tolerance;
+
+  int N_IT_LOG;
+
+  uint64_t _iterations;
+
+  // Pivot statistics of the last run
+  SimplexStats _stats;
+
+public:
+  NetSimplexGrid(int node_num, int xmax, int ymax, int border)
+      : NetSimplexGrid(nullptr, std::make_shared<GridNetwork<Cost>>(
+                                     node_num, xmax, ymax, border)) {}
+
+  // Solver on a network shared with other solvers: the network must be
+  // complete, since a shared network cannot be changed
+  explicit NetSimplexGrid(std::shared_ptr<const GridNetwork<Cost>> net)
+      : NetSimplexGrid(std::move(net), nullptr) {}
+
+private:
+  NetSimplexGrid(std::shared_ptr<const GridNetwork<Cost>> net,
+                 std::shared_ptr<GridNetwork<Cost>> own)
+      : _net(net ? std::move(net) : own), _own(std::move(own)),
+        _node_num(_net->nodeNum()), _grid(_net->grid()), _pos(_net->pos()),
+        _offset(_net->offset()), _dir_cost(_net->dirCost()),
+        _dir_num(_net->dirNum()), _dummy_arc(_node_num * _dir_num),
+        _art_cost(0), _root(-1), _next_node(0), in_arc(-1), join(-1),
+        u_in(-1), v_in(-1), u_out(-1), v_out(-1), MAX((std::numeric_limits<Value>::max)()),
+        INF(std::numeric_limits<Value>::has_infinity
+                ? std::numeric_limits<Value>::infinity()
+                : MAX),
+        _runtime(0.0) {
+    // Check the number types
+    if (!std::numeric_limits<Value>::is_signed)
+      throw std::runtime_error(
+          "The flow type of NetworkSimplex must be signed");
+    if (!std::numeric_limits<Cost>::is_signed)
+      throw std::runtime_error(
+          "The cost type of NetworkSimplex must be signed");
+
+    // Reset data structures
+    int all_node_num = _node_num + 1;
+    _supply.resize(all_node_num, 0);
+    _pi.resize(all_node_num);
+
+    _parent.resize(all_node_num);
+    _pred.resize(all_node_num);
+    _pred_flow.resize(all_node_num);
+    _pred_dir.resize(all_node_num);
+    _thread.resize(all_node_num);
+    _rev_thread.resize(all_node_num);
+    _succ_num.resize(all_node_num);
+    _last_succ.resize(all_node_num);
+
+    // Interal parameters
+    N_IT_LOG = 1000; // log every N_IT_LOG iterations
+    _timelimit = std::numeric_limits<double>::max();
+    _deadline = deadlineAfter(_timelimit);
+    _cancel = nullptr;
+    _verbosity = KWD_VAL_INFO;
+    _opt_tolerance = 1e-06;
+    _iterations = 0;
+  }
+
+public:
+  ProblemType run(PivotRule pivot_rule = PivotRule::BLOCK_SEARCH) {
+    _runtime = 0.0;
+    _iterations = 0;
+    _stats = SimplexStats();
+
+    if (!init())
+      return ProblemType::INFEASIBLE;
+    return start(pivot_rule);
+  }
+
+  uint64_t iterations() const { return _iterations; }
+
+  // Pivot statistics of the last run (see KWD_PROFILE)
+  const SimplexStats &stats() const { return _stats; }
+
+  // Place node i on the cell (x, y) of the grid
+  void setNode(int i, int x, int y) { ownNetwork().setNode(i, x, y); }
+
+  // Set the supply of node i
+  void addNode(int i, Value b) { _supply[i] = b; }
+
+  // Add the arcs from every node along the direction (v, w)
+  void addDirection(int v, int w, Cost c) {
+    ownNetwork().addDirection(v, w, c);
+    _dir_num = _net->dirNum();
+    _dummy_arc = _node_num * _dir_num;
+  }
+
+  // Parameters
+  void setTimelimit(double t) {
+    _timelimit = t;
+    _deadline = deadlineAfter(t);
+    PRINT("INFO: change <timelimit> to %f\n", t);
+  }
+  void setCancelToken(const CancelToken *token) { _cancel = token; }
+  void setOptTolerance(double o) {
+    _opt_tolerance = o;
+    PRINT("INFO: change <opt_tolerance> to %f\n", o);
+  }
+  void setVerbosity(std::string v) {
+    _verbosity = v;
+    if (v == KWD_VAL_DEBUG)
+      N_IT_LOG = 100000;
+    if (v == KWD_VAL_INFO)
+      N_IT_LOG = 10000000;
+    if (v == KWD_VAL_SILENT)
+      N_IT_LOG = 0;
+    PRINT("INFO: change <verbosity> to %s\n", v.c_str());
+  }
+
+  // Set all the parameters without logging, as needed by the worker
+  // threads of a batch
+  void setParams(double timelimit, const CancelToken *token,
+                 const std::string &verbosity, double opt_tolerance) {
+    _timelimit = timelimit;
+    _deadline = deadlineAfter(timelimit);
+    _cancel = token;
+    _opt_tolerance = opt_tolerance;
+    _verbosity = verbosity;
+    if (verbosity == KWD_VAL_DEBUG)
+      N_IT_LOG = 100000;
+    if (verbosity == KWD_VAL_INFO)
+      N_IT_LOG = 10000000;
+    if (verbosity == KWD_VAL_SILENT)
+      N_IT_LOG = 0;
+  }
+
+  double runtime() const { return _runtime; }
+
+  size_t num_nodes() const { return _node_num; }
+
+  // Number of implicit arcs (counted on demand)
+  size_t num_arcs() const { return _net->num_arcs(); }
+
+  // Number of explicitly stored arcs, that is, the spanning tree arcs
+  size_t num_stored_arcs() const { return _node_num; }
+
+  Cost totalCost() const {
+    Cost c = 0;
+    for (int u = 0; u < _node_num; ++u)
+      if (_pred[u] < _dummy_arc)
+        c += _pred_flow[u] * _dir_cost[_pred[u] % _dir_num];
+
+    return c;
+  }
+
+  Cost totalFlow() const {
+    Cost tot_flow = 0;
+    for (int u = 0; u < _node_num; ++u)
+      if (_pred[u] < _dummy_arc)
+        tot_flow += _pred_flow[u];
+
+    return tot_flow;
+  }
+
+  // Potential of node n
+  Cost potential(int n) const { return _pi[n]; }
+
+private:
+  // The network can be changed only by the solver that owns it
+  GridNetwork<Cost> &ownNetwork() {
+    if (!_own)
+      throw std::runtime_error("ERROR 306: the grid network is shared");
+    return *_own;
+  }
+
+  // Implicit arc data
+  int arcSource(int e) const {
+    if (e < _dummy_arc)
+      return e / _dir_num;
+    int u = e - _dummy_arc;
+    return _supply[u] >= 0 ? u : _root;
+  }
+
+  int arcTarget(int e) const {
+    if (e < _dummy_arc)
+      return _grid[_pos[e / _dir_num] + _offset[e % _dir_num]];
+    int u = e - _dummy_arc;
+    return _supply[u] >= 0 ? _root : u;
+  }
+
+  Cost arcCost(int e) const {
+    if (e < _dummy_arc)
+      return _dir_cost[e % _dir_num];
+    return _supply[e - _dummy_arc] >= 0 ? 0 : _art_cost;
+  }
+
+  bool init() {
+    if (_node_num == 0 || _dir_num == 0)
+      return false;
+
+    // Check the sum of supply values
+    Value sum_supply = 0;
+    for (int i = 0; i != _node_num; ++i)
+      sum_supply += _supply[i];
+
+    // Initialize artifical cost
+    Cost art_cost = 0;
+    for (int k = 0; k < _dir_num; ++k)
+      if (_dir_cost[k] > art_cost)
+        art_cost = _dir_cost[k];
+    _art_cost = (art_cost + 1) * _node_num;
+
+    // Set data for the artificial root node
+    _root = _node_num;
+    _parent[_root] = -1;
+    _pred[_root] = -1;
+    _thread[_root] = 0;
+    _rev_thread[0] = _root;
+    _succ_num[_root] = _node_num + 1;
+    _last_succ[_root] = _root - 1;
+    _supply[_root] = -sum_supply;
+    _pi[_root] = 0;
+    _next_node = 0;
+
+    // Add artificial arcs and initialize the spanning tree data structure
+    for (int u = 0; u != _node_num; ++u) {
+      _parent[u] = _root;
+      _pred[u] = _dummy_arc + u;
+      _thread[u] = u + 1;
+      _rev_thread[u + 1] = u;
+      _succ_num[u] = 1;
+      _last_succ[u] = u;
+      if (_supply[u] >= 0) {
+        _pred_dir[u] = DIR_UP;
+        _pi[u] = 0;
+        _pred_flow[u] = _supply[u];
+      } else {
+        _pred_dir[u] = DIR_DOWN;
+        _pi[u] = _art_cost;
+        _pred_flow[u] = -_supply[u];
+      }
+    }
+
+    return true;
+  }
+
+  // Block search over the implicit arcs, visiting the nodes in a circular
+  // order and all the directions of a node in the same block
+  bool findEnteringArc(int block_size, Cost negeps) {
+    Cost min = negeps;
+    int cnt = block_size;
+    int u = _next_node;
+
+    for (int i = 0; i < _node_num; ++i, ++u) {
+      if (u == _node_num)
+        u = 0;
+      const int p = _pos[u];
+      const Cost pu = _pi[u];
+      for (int k = 0; k < _dir_num; ++k) {
+        int t = _grid[p + _offset[k]];
+        if (t >= 0) {
+          Cost c = _dir_cost[k] + pu - _pi[t];
+          // The arcs of the tree have zero reduced cost up to round off
+          if (c < min && _pred[u] != u * _dir_num + k &&
+              _pred[t] != u * _dir_num + k) {
+            min = c;
+            in_arc = u * _dir_num + k;
+          }
+        }
+      }
+      cnt -= _dir_num;
+      if (cnt <= 0) {
+        if (min < negeps) {
+          _next_node = u + 1;
+          return true;
+        }
+        cnt = block_size;
+      }
+    }
+
+    if (min >= negeps)
+      return false;
+
+    _next_node = in_arc / _dir_num + 1;
+    return true;
+  }
+
+  // Find the join node
+  void findJoinNode() {
+    int u = arcSource(in_arc);
+    int v = arcTarget(in_arc);
+    while (u != v) {
+      KWD_PROFILE_ADD(_stats.cycle_nodes, 1);
+      if (_succ_num[u] < _succ_num[v]) {
+        u = _parent[u];
+      } else {
+        v = _parent[v];
+      }
+    }
+    join = u;
+  }
+
+  // Find the leaving arc of the cycle and returns true if the
+  // leaving arc is not the same as the entering arc
+  bool findLeavingArc() {
+    // Initialize first and second nodes according to the direction
+    // of the cycle
+    int first = arcSource(in_arc);
+    int second = arcTarget(in_arc);
+
+    delta = MAX;
+    int result = 0;
+    Value d;
+
+    // Search the cycle form the first node to the join node
+    for (int u = first; u != join; u = _parent[u]) {
+      d = _pred_flow[u];
+      if (_pred_dir[u] == DIR_DOWN)
+        d = INF - d;
+
+      if (d < delta) {
+        delta = d;
+        u_out = u;
+        result = 1;
+      }
+    }
+
+    // Search the cycle form the second node to the join node
+    for (int u = second; u != join; u = _parent[u]) {
+      d = _pred_flow[u];
+      if (_pred_dir[u] == DIR_UP)
+        d = INF - d;
+
+      if (d <= delta) {
+        delta = d;
+        u_out = u;
+        result = 2;
+      }
+    }
+
+    if (result == 1) {
+      u_in = first;
+      v_in = second;
+    } else {
+      u_in = second;
+      v_in = first;
+    }
+
+    return result != 0;
+  }
+
+  // Change the flow of the tree arcs along the cycle
+  void changeFlow() {
+    if (delta > 0) {
+      for (int u = arcSource(in_arc); u != join; u = _parent[u])
+        _pred_flow[u] -= _pred_dir[u] * delta;
+      for (int u = arcTarget(in_arc); u != join; u = _parent[u])
+        _pred_flow[u] += _pred_dir[u] * delta;
+    }
+  }
+
+  // Update the tree structure: the flow of the tree arcs moves together
+  // with _pred
+  void updateTreeStructure() {
+    int old_rev_thread = _rev_thread[u_out];
+    int old_succ_num = _succ_num[u_out];
+    int old_last_succ = _last_succ[u_out];
+    v_out = _parent[u_out];
+    int in_source = arcSource(in_arc);
+
+    // Check if u_in and u_out coincide
+    if (u_in == u_out) {
+      // Update _parent, _pred, _pred_dir
+      _parent[u_in] = v_in;
+      _pred[u_in] = in_arc;
+      _pred_flow[u_in] = delta;
+      _pred_dir[u_in] = u_in == in_source ? DIR_UP : DIR_DOWN;
+
+      // Update _thread and _rev_thread
+      if (_thread[v_in] != u_out) {
+        int after = _thread[old_last_succ];
+        _thread[old_rev_thread] = after;
+        _rev_thread[after] = old_rev_thread;
+        after = _thread[v_in];
+        _thread[v_in] = u_out;
+        _rev_thread[u_out] = v_in;
+        _thread[old_last_succ] = after;
+        _rev_thread[after] = old_last_succ;
+      }
+    } else {
+      // Handle the case when old_rev_thread equals to v_in
+      // (it also means that join and v_out coincide)
+      int thread_continue =
+          old_rev_thread == v_in ? _thread[old_last_succ] : _thread[v_in];
+
+      // Update _thread and _parent along the stem nodes (i.e. the nodes
+      // between u_in and u_out, whose parent have to be changed)
+      int stem = u_in;             // the current stem node
+      int par_stem = v_in;         // the new parent of stem
+      int next_stem;               // the next stem node
+      int last = _last_succ[u_in]; // the last successor of stem
+      int before, after = _thread[last];
+      _thread[v_in] = u_in;
+      _dirty_revs.clear();
+      _dirty_revs.push_back(v_in);
+      while (stem != u_out) {
+        KWD_PROFILE_ADD(_stats.stem_nodes, 1);
+        // Insert the next stem node into the thread list
+        next_stem = _parent[stem];
+        _thread[last] = next_stem;
+        _dirty_revs.push_back(last);
+
+        // Remove the subtree of stem from the thread list
+        before = _rev_thread[stem];
+        _thread[before] = after;
+        _rev_thread[after] = before;
+
+        // Change the parent node and shift stem nodes
+        _parent[stem] = par_stem;
+        par_stem = stem;
+        stem = next_stem;
+
+        // Update last and after
+        last = _last_succ[stem] == _last_succ[par_stem] ? _rev_thread[par_stem]
+                                                        : _last_succ[stem];
+        after = _thread[last];
+      }
+      _parent[u_out] = par_stem;
+      _thread[last] = thread_continue;
+      _rev_thread[thread_continue] = last;
+      _last_succ[u_out] = last;
+
+      // Remove the subtree of u_out from the thread list except for
+      // the case when old_rev_thread equals to v_in
+      if (old_rev_thread != v_in) {
+        _thread[old_rev_thread] = after;
+        _rev_thread[after] = old_rev_thread;
+      }
+
+      // Update _rev_thread using the new _thread values
+      for (int i = 0; i != int(_dirty_revs.size()); ++i) {
+        int u = _dirty_revs[i];
+        _rev_thread[_thread[u]] = u;
+      }
+
+      // Update _pred, _pred_dir, _last_succ and _succ_num for the
+      // stem nodes from u_out to u_in
+      int tmp_sc = 0, tmp_ls = _last_succ[u_out];
+      for (int u = u_out, p = _parent[u]; u != u_in; u = p, p = _parent[u]) {
+        _pred[u] = _pred[p];
+        _pred_flow[u] = _pred_flow[p];
+        _pred_dir[u] = -_pred_dir[p];
+        tmp_sc += _succ_num[u] - _succ_num[p];
+        _succ_num[u] = tmp_sc;
+        _last_succ[p] = tmp_ls;
+      }
+      _pred[u_in] = in_arc;
+      _pred_flow[u_in] = delta;
+      _pred_dir[u_in] = u_in == in_source ? DIR_UP : DIR_DOWN;
+      _succ_num[u_in] = old_succ_num;
+    }
+
+    // Update _last_succ from v_in towards the root
+    int up_limit_out = _last_succ[join] == v_in ? join : -1;
+    int last_succ_out = _last_succ[u_out];
+    for (int u = v_in; u != -1 && _last_succ[u] == v_in; u = _parent[u]) {
+      _last_succ[u] = last_succ_out;
+    }
+
+    // Update _last_succ from v_out towards the root
+    if (join != old_rev_thread && v_in != old_rev_thread) {
+      for (int u = v_out; u != up_limit_out && _last_succ[u] == old_last_succ;
+           u = _parent[u]) {
+        _last_succ[u] = old_rev_thread;
+      }
+    } else if (last_succ_out != old_last_succ) {
+      for (int u = v_out; u != up_limit_out && _last_succ[u] == old_last_succ;
+           u = _parent[u]) {
+        _last_succ[u] = last_succ_out;
+      }
+    }
+
+    // Update _succ_num from v_in to join
+    for (int u = v_in; u != join; u = _parent[u]) {
+      _succ_num[u] += old_succ_num;
+    }
+    // Update _succ_num from v_out to join
+    for (int u = v_out; u != join; u = _parent[u]) {
+      _succ_num[u] -= old_succ_num;
+    }
+  }
+
+  // Update potentials in the subtree that has been moved
+  void updatePotential() {
+    Cost sigma = _pi[v_in] - _pi[u_in] - _pred_dir[u_in] * arcCost(in_arc);
+    int end = _thread[_last_succ[u_in]];
+
+    for (int u = u_in; u != end; u = _thread[u]) {
+      _pi[u] += sigma;
+    }
+  }
+
+  // Check the deadline and the cancel token, and set the status to report
+  bool interrupted(ProblemType &status) const {
+    if (_cancel != nullptr && _cancel->cancelled()) {
+      status = ProblemType::CANCELLED;
+      return true;
+    }
+    if (std::chrono::steady_clock::now() > _deadline) {
+      status = ProblemType::TIMELIMIT;
+      return true;
+    }
+    return false;
+  }
+
+  // Execute the algorithm: only the block search pivot rule is available
+  // on implicit arcs
+  ProblemType start(PivotRule) {
+    auto start_tt = std::chrono::steady_clock::now();
+    ProblemType status;
+    if (interrupted(status))
+      return status;
+
+    // The main parameters of the pivot rule
+    const double BLOCK_SIZE_FACTOR = 1;
+    const int MIN_BLOCK_SIZE = 20;
+
+    int block_size = (std::max)(
+        int(BLOCK_SIZE_FACTOR * std::sqrt(double(_node_num) * _dir_num)),
+        MIN_BLOCK_SIZE);
+    const Cost negeps = std::nextafter(-_opt_tolerance, -0.0);
+
+    // Execute the Network Simplex algorithm
+    bool found = false;
+    while (true) {
+      KWD_PROFILE_PHASE(_stats.t_enter,
+                        found = findEnteringArc(block_size, negeps));
+      if (!found)
+        break;
+
+      KWD_PROFILE_PHASE(_stats.t_join, findJoinNode());
+      KWD_PROFILE_PHASE(_stats.t_leave, findLeavingArc());
+      KWD_PROFILE_ADD(_stats.degenerate_pivots, delta == 0);
+      KWD_PROFILE_PHASE(_stats.t_flow, changeFlow());
+      KWD_PROFILE_PHASE(_stats.t_tree, updateTreeStructure());
+      KWD_PROFILE_PHASE(_stats.t_potential, updatePotential());
+      KWD_PROFILE_ADD(_stats.subtree_nodes, _succ_num[u_in]);
+      KWD_PROFILE_ADD(_stats.pivots, 1);
+
+      // Add as log file
+      _iterations++;
+      if (_iterations % CHECK_INTERVAL == 0 && interrupted(status))
+        return status;
+      if (N_IT_LOG > 0) {
+        if (_iterations % N_IT_LOG == 0) {
+          auto end_t = std::chrono::steady_clock::now();
+          double tot =
+              double(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         end_t - start_tt)
+                         .count()) /
+              1000000000;
+          if (_verbosity == KWD_VAL_DEBUG)
+            PRINT("NetSIMPLEX inner loop | it: %ld, distance: %.4f, runtime: "
+                  "%.4f\n",
+                  _iterations, totalCost(), tot);
+        }
+      }
+    }
+
+    auto end_t = std::chrono::steady_clock::now();
+    _runtime += double(std::chrono::duration_cast<std::chrono::milliseconds>(
+                           end_t - start_tt)
+                           .count()) /
+                1000;
+
+    if (_verbosity == KWD_VAL_DEBUG) {
+      PRINT("NetSIMPLEX outer loop | runtime: %.3f\n", _runtime);
+      _stats.dump();
+    }
+
+    return ProblemType::OPTIMAL;
+  }
+};
+} // namespace KWD
@@ -0,0 +1,64 @@
+/*
+ * @fileoverview Copyright (c) 2019-2021, Stefano Gualandi,
+ *               via Ferrata, 5, I-27100, Pavia, Italy
+ *
+ * @author stefano.gualandi@gmail.com (Stefano Gualandi)
+ *
+ */
+
+// Benchmark of the arc storage layout of NetSimplex on grid workloads.
+// Build it twice, with and without -DKWD_PACKED_ARCS, and compare the
+// runtimes (see the target benchlayout in the Makefile).
+
+#include <random>
+
+#include "KWD_Histogram2D.h"
+
+int main(int argc, char *argv[]) {
+  int n = 64;
+  if (argc > 1)
+    n = atoi(argv[1]);
+
+  int seed = 13;
+  std::mt19937 gen(seed);
+  std::uniform_real_distribution<> Uniform01(0, 1);
+
+  // Two random histograms on a full n x n grid
+  vector<int> Xs, Ys;
+  vector<double> W1, W2;
+  for (int i = 0; i < n; ++i)
+    for (int j = 0; j < n; ++j) {
+      Xs.push_back(i);
+      Ys.push_back(j);
+      W1.push_back(Uniform01(gen));
+      W2.push_back(Uniform01(gen));
+    }
+
+#ifdef KWD_PACKED_ARCS
+  const char *layout = "packed";
+#else
+  const char *layout = "vectors";
+#endif
+
+  for (int L : {2, 3, 5}) {
+    KWD::Solver solver;
+    solver.setStrParam(KWD_PAR_VERBOSITY, KWD_VAL_SILENT);
+    solver.setStrParam(KWD_PAR_ALGORITHM, KWD_VAL_FULLMODEL);
+
+    auto start_t = std::chrono::steady_clock::now();
+    double dist = solver.compareApprox(static_cast<int>(Xs.size()), &Xs[0],
+                                       &Ys[0], &W1[0], &W2[0], L);
+    auto end_t = std::chrono::steady_clock::now();
+    double elapsed = double(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                end_t - start_t)
+                                .count()) /
+                     1000;
+
+    PRINT("Layout %s => %d, L=%d: fobj: %.6f, simplex: %.3f, total: %.3f, "
+          "iter: %ld, arcs: %ld, nodes: %ld\n",
+          layout, n, L, dist, solver.runtime(), elapsed, solver.iterations(),
+          solver.num_arcs(), solver.num_nodes());
+  }
+
+  return EXIT_SUCCESS;
+}
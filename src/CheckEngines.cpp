@@ -0,0 +1,90 @@
+/*
+ * @fileoverview Copyright (c) 2019-2021, Stefano Gualandi,
+ *               via Ferrata, 5, I-27100, Pavia, Italy
+ *
+ * @author stefano.gualandi@gmail.com (Stefano Gualandi)
+ *
+ */
+
+// Regression check of the alternative engines on a fixed small grid: every
+// engine must give the distance of the reference engine, up to the error
+// bound it reports (see the target checkengines in the Makefile).
+
+#include <random>
+
+#include "KWD_Histogram2D.h"
+
+// Compare the distance d of an engine with the reference distance ref,
+// accepting an absolute error up to bound
+bool check(const char *name, double d, double ref, double bound) {
+  bool ok = std::fabs(d - ref) <= bound + 1e-6 * std::max(1.0, std::fabs(ref));
+  PRINT("%s %s: %.9f, reference: %.9f, error bound: %.3g\n",
+        ok ? "passed" : "FAILED", name, d, ref, bound);
+  return ok;
+}
+
+int main(int argc, char *argv[]) {
+  int n = 12;
+  if (argc > 1)
+    n = atoi(argv[1]);
+
+  int seed = 13;
+  std::mt19937 gen(seed);
+  std::uniform_real_distribution<> Uniform01(0, 1);
+
+  // Two random histograms on a full n x n grid, with different total mass
+  vector<int> Xs, Ys;
+  vector<double> W1, W2;
+  for (int i = 0; i < n; ++i)
+    for (int j = 0; j < n; ++j) {
+      Xs.push_back(i);
+      Ys.push_back(j);
+      W1.push_back(Uniform01(gen));
+      W2.push_back(2 * Uniform01(gen));
+    }
+  int m = static_cast<int>(Xs.size());
+  int L = 3;
+
+  bool ok = true;
+
+  // Unbalanced transport: capacitated network against big-M costs
+  {
+    KWD::Solver s1, s2;
+    for (KWD::Solver *s : {&s1, &s2}) {
+      s->setStrParam(KWD_PAR_VERBOSITY, KWD_VAL_SILENT);
+      s->setStrParam(KWD_PAR_ALGORITHM, KWD_VAL_FULLMODEL);
+      s->setStrParam(KWD_PAR_UNBALANCED, KWD_VAL_TRUE);
+      s->setDblParam(KWD_PAR_UNBALANCED_COST, 1000);
+    }
+    s1.setStrParam(KWD_PAR_CAPACITATED, KWD_VAL_TRUE);
+    double d = s1.compareApprox(m, &Xs[0], &Ys[0], &W1[0], &W2[0], L);
+    double ref = s2.compareApprox(m, &Xs[0], &Ys[0], &W1[0], &W2[0], L);
+    ok &= check("capacitated vs big-M", d, ref, s1.errorBound());
+  }
+
+  // Cost scaling against the network simplex on the full model
+  {
+    KWD::Solver s1, s2;
+    for (KWD::Solver *s : {&s1, &s2})
+      s->setStrParam(KWD_PAR_VERBOSITY, KWD_VAL_SILENT);
+    s1.setStrParam(KWD_PAR_ALGORITHM, KWD_VAL_COSTSCALING);
+    s2.setStrParam(KWD_PAR_ALGORITHM, KWD_VAL_FULLMODEL);
+    double d = s1.compareApprox(m, &Xs[0], &Ys[0], &W1[0], &W2[0], L);
+    double ref = s2.compareApprox(m, &Xs[0], &Ys[0], &W1[0], &W2[0], L);
+    ok &= check("costscaling vs fullmodel", d, ref, s1.errorBound());
+  }
+
+  // Auction against the network simplex on the bipartite model
+  {
+    KWD::Solver s1, s2;
+    for (KWD::Solver *s : {&s1, &s2})
+      s->setStrParam(KWD_PAR_VERBOSITY, KWD_VAL_SILENT);
+    s1.setStrParam(KWD_PAR_ALGORITHM, KWD_VAL_AUCTION);
+    s2.setStrParam(KWD_PAR_ALGORITHM, KWD_VAL_BIPARTITE);
+    double d = s1.compareExact(m, &Xs[0], &Ys[0], &W1[0], &W2[0]);
+    double ref = s2.compareExact(m, &Xs[0], &Ys[0], &W1[0], &W2[0]);
+    ok &= check("auction vs bipartite", d, ref, s1.errorBound());
+  }
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -88,6 +88,9 @@ Rcpp::List compareOneToOne(
     if (method == KWD_VAL_APPROX) {
       Rprintf("CompareOneToOne, Solution method: APPROX\n");
       d = s.compareApprox(n, Xs, Ys, W1, W2, LL);
+    } else if (method == KWD_VAL_MULTISCALE) {
+      Rprintf("CompareOneToOne, Solution method: MULTISCALE\n");
+      d = s.compareApprox(n, Xs, Ys, W1, W2, LL);
     } else {
       Rprintf("CompareOneToOne, Solution method: EXACT\n");
       d = s.compareExact(n, Xs, Ys, W1, W2);
@@ -18,6 +18,7 @@ cdef extern from "KWD_Histogram2D.h" namespace "KWD":
         double compareApprox(int, int*, int*, double*, double*, int)
         vector[double] compareApprox(int, int, int*, int*, double*, double*, int)
         vector[double] compareApprox3(int, int, int*, int*, double*, int)        
+        vector[double] compareApproxIncremental(int, int*, int*, double*, double*, int, double)
         double distance(const Histogram2D& A, const Histogram2D& B, int L)
         double column_generation(const Histogram2D& A, const Histogram2D& B, int L)
         double dense(const Histogram2D& A, const Histogram2D& B)
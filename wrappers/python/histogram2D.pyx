@@ -122,6 +122,25 @@ cdef class Solver:
         cdef double[::1] Wmvs = Ws.flatten()
 
         return self.m.compareApprox3(n, m, &Xmv[0], &Ymv[0], &Wmvs[0], L)
+
+    def compareApproxIncremental(self, n, X, Y, W1, W2, L, stop_tol=0.0):
+        if not X.flags['C_CONTIGUOUS']:
+            X = np.ascontiguousarray(X, dtype=np.int32)
+        cdef int[::1] Xmv = X
+
+        if not Y.flags['C_CONTIGUOUS']:
+            Y = np.ascontiguousarray(Y, dtype=np.int32)
+        cdef int[::1] Ymv = Y
+
+        if not W1.flags['C_CONTIGUOUS']:
+            W1 = np.ascontiguousarray(W1, dtype=float)
+        cdef double[::1] Wmv1 = W1
+
+        if not W2.flags['C_CONTIGUOUS']:
+            W2 = np.ascontiguousarray(W2, dtype=float)
+        cdef double[::1] Wmv2 = W2
+
+        return self.m.compareApproxIncremental(n, &Xmv[0], &Ymv[0], &Wmv1[0], &Wmv2[0], L, stop_tol)
     
     def distance(self, Histogram2D A, Histogram2D B, L):
         return self.m.distance(A.mu, B.mu, L)
@@ -219,7 +238,7 @@ def compareOneToOne(Coordinates, Weights, Options):
     Options : dict
         Dictionary of options:
             'L': approximation parameter. Data type: positive integer
-            'method': for computing the KW distances: 'exact' or 'approx'
+            'method': for computing the KW distances: 'exact', 'approx' or 'multiscale'
             'model': network model: 'bipartite' or 'mincostflow'
             'algorithm': for the KW distances: 'fullmodel' or 'colgen'
             'verbosity': options 'silent', 'info', 'debug'
@@ -250,7 +269,7 @@ def compareOneToOne(Coordinates, Weights, Options):
 
     d = -1
     method = Options.get('Method', 'approx').encode('utf-8')
-    if method == 'approx'.encode('utf-8'):
+    if method == 'approx'.encode('utf-8') or method == 'multiscale'.encode('utf-8'):
         d = s.compareApprox(n, X, Y, W1, W2, L)
     else:
         d = s.compareExact(n, X, Y, W1, W2)